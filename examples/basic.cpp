@@ -76,6 +76,11 @@ int main()
 
     bool running = true;
 
+    /*
+        Frames are converted to the format the renderer stores textures in, so uploading them is a plain copy.
+    */
+    GleedSetVideoOutputFormat(movie, GleedGetRendererVideoOutputFormat(renderer, false));
+
     /*
         This is a helper method that allows creating a texture for rendering video frames with SDL_Renderer.
 
@@ -79,7 +79,7 @@ extern "C"
      *
      * Represents single opened and parsed .webm file.
      *
-     * Movie can be created via GleedOpen or GleedOpenIO functions.
+     * Movie can be created via GleedOpen or GleedOpenIO functions, or cloned from another one with GleedCloneMovie.
      * It must be freed with GleedFreeMovie function after no longer needed.
      *
      * Gleed API allows loading WebM file and per-frame decoding, but nothing more.
@@ -127,9 +127,14 @@ extern "C"
 
         bool lacing; /**< True if the track uses lacing */
 
-        Uint32 video_width;      /**< Video frame width, non-zero only for video tracks */
-        Uint32 video_height;     /**< Video frame height, non-zero only for video tracks */
-        double video_frame_rate; /**< Video frame rate, may not be specified in the file */
+        Uint32 video_width;       /**< Video frame width, non-zero only for video tracks */
+        Uint32 video_height;      /**< Video frame height, non-zero only for video tracks */
+        Uint32 video_crop_top;    /**< Pixels to crop from the top of the frame (Matroska PixelCrop), applied by default */
+        Uint32 video_crop_bottom; /**< Pixels to crop from the bottom of the frame */
+        Uint32 video_crop_left;   /**< Pixels to crop from the left of the frame */
+        Uint32 video_crop_right;  /**< Pixels to crop from the right of the frame */
+        double video_frame_rate;  /**< Video frame rate, may not be specified in the file */
+        bool video_alpha;         /**< Video has an alpha channel (Matroska AlphaMode), frames are converted to RGBA32 by default */
 
         double audio_sample_frequency; /**< Audio sample frequency, non-zero only for audio tracks */
         double audio_output_frequency; /**< Audio output frequency, non-zero only for audio tracks */
@@ -137,6 +142,73 @@ extern "C"
         Uint32 audio_bit_depth;        /**< Audio bit depth, non-zero only for audio tracks */
     } GleedMovieTrack;
 
+    /**
+     * Video decode quality, trading picture quality for decoding speed
+     *
+     * See GleedSetVideoDecodeQuality.
+     */
+    typedef enum
+    {
+        GLEED_VIDEO_QUALITY_FULL = 0,    /**< Full quality, the default */
+        GLEED_VIDEO_QUALITY_FAST = 1,    /**< Point sampled scaling and no dithering of high bit depth video during conversion */
+        GLEED_VIDEO_QUALITY_FASTEST = 2, /**< As FAST, and the VP9 in-loop deblocking filter is skipped */
+    } GleedVideoDecodeQuality;
+
+    /**
+     * Video decoding statistics
+     *
+     * Counters are accumulated since the movie was opened and can be obtained with GleedGetVideoStats.
+     */
+    typedef struct
+    {
+        Uint32 decoded_frames;      /**< Frames passed through the video decoder, including hidden ones */
+        Uint32 converted_frames;    /**< Frames converted to output pixels */
+        Uint32 skipped_conversions; /**< Frames decoded only to keep codec state, as they would never be displayed */
+        Uint32 dropped_frames;      /**< Non-reference frames that were skipped without decoding at all */
+        Uint32 late_frames;         /**< Frames decoded ahead by the player, but dropped as the playhead was already past them */
+        Uint64 decode_ns;           /**< Total time spent in the video decoder, in nanoseconds */
+        Uint64 convert_ns;          /**< Total time spent converting frames to output pixels, in nanoseconds */
+        Uint32 cache_hits;          /**< Frames taken from the frame cache instead of being decoded, see GleedSetVideoFrameCacheEnabled */
+
+        Uint32 quality_decoded_frames[GLEED_VIDEO_QUALITY_FASTEST + 1]; /**< decoded_frames split by the GleedVideoDecodeQuality they were decoded with */
+        Uint64 quality_decode_ns[GLEED_VIDEO_QUALITY_FASTEST + 1];      /**< decode_ns split the same way, see GleedGetVideoDecodeTimeDelta */
+    } GleedMovieVideoStats;
+
+    /**
+     * Decoded video frame in its native planar YUV form, as produced by the video decoder
+     *
+     * Planes are read-only and stay valid until the frame is released with GleedReleaseVideoFrameYUV,
+     * even if the movie keeps decoding or is freed in the meantime.
+     */
+    typedef struct
+    {
+        int w;                     /**< Width of the luma plane in pixels */
+        int h;                     /**< Height of the luma plane in pixels */
+        int chroma_shift_x;        /**< Chroma planes are (w + chroma_shift_x) >> chroma_shift_x pixels wide (1 for 4:2:0) */
+        int chroma_shift_y;        /**< Chroma planes are (h + chroma_shift_y) >> chroma_shift_y pixels high (1 for 4:2:0) */
+        int bit_depth;             /**< Bits per sample: 8, or 10 and 12 with every sample stored in a 16-bit word */
+        const Uint8 *planes[3];    /**< Y, U and V planes */
+        int pitches[3];            /**< Bytes between rows of each plane */
+        SDL_Colorspace colorspace; /**< YUV colorspace of the frame, defining its matrix and range */
+        Uint32 frame;              /**< Index of the frame in the video track */
+    } GleedVideoFrameYUV;
+
+    /**
+     * Colour transform applied to video frames while they are converted, see GleedSetVideoColorTransform
+     *
+     * Stages run in order: matrix, lookup table, fade. A zeroed structure is the identity, so set only the stages you need.
+     * Channels are in the 0..1 range for the matrix and the fade, and 0..255 for the lookup table.
+     */
+    typedef struct
+    {
+        bool use_matrix;       /**< Apply the matrix */
+        float matrix[3][4];    /**< Rows give output R, G and B from input (R, G, B, 1), e.g. for colour-blind filters or saturation */
+        bool use_lut;          /**< Apply the lookup table */
+        Uint8 lut[3][256];     /**< Output value of each input value, per channel (R, G, B), e.g. a gamma curve */
+        float fade;            /**< How far colour is faded to fade_color: 0 not at all, 1 fully */
+        SDL_FColor fade_color; /**< Colour faded to, its alpha is ignored */
+    } GleedColorTransform;
+
     /**
      * Audio sample type
      */
@@ -169,6 +241,23 @@ extern "C"
      */
     extern GleedMovie *GleedOpenIO(SDL_IOStream *io);
 
+    /**
+     * Create another instance of an already opened movie
+     *
+     * The clone shares the parsed tracks and frame index with the original movie, so the file is not parsed again.
+     * It has its own playback position and decoders, and starts as if freshly opened, with the same tracks selected.
+     * Once created, both instances may be used and freed independently, in any order, each from its own thread.
+     * Cloning reads the track selection of the original, so don't select its tracks on another thread meanwhile.
+     *
+     * The new IO stream must read the same file (or data) as the original movie's stream.
+     *
+     * \param movie GleedMovie instance to clone
+     * \param io SDL IO stream for the clone, closed by GleedFreeMovie as usual if requested
+     *
+     * \returns Pointer to the new GleedMovie, or NULL on error. Call GleedGetError to get the error message.
+     */
+    extern GleedMovie *GleedCloneMovie(GleedMovie *movie, SDL_IOStream *io);
+
     /**
      * Free (release) a movie instance
      *
@@ -236,8 +325,10 @@ extern "C"
      * and independently from the movie.
      * This also means that calling this function again will create a new texture, not update the existing one.
      *
-     * Texture format is SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING access mode
-     * and the size is the same as the video frame size.
+     * Texture format is the video output format (see GleedSetVideoOutputFormat), SDL_TEXTUREACCESS_STREAMING access mode
+     * and the size is the same as the video frame size (see GleedGetVideoSize).
+     * For videos with alpha, the blend mode is set to match GleedSetVideoPremultipliedAlpha.
+     * Videos without alpha converted to a format with alpha get SDL_BLENDMODE_NONE.
      *
      * Contents of the texture can be easily updated with GleedUpdatePlaybackTexture function.
      *
@@ -248,6 +339,21 @@ extern "C"
      */
     extern SDL_Texture *GleedCreatePlaybackTexture(GleedMovie *movie, SDL_Renderer *renderer);
 
+    /**
+     * Pick the video output format a renderer stores natively
+     *
+     * Renderers list the texture formats they support, best first. This function returns the first one
+     * that frames can be converted to, so passing it to GleedSetVideoOutputFormat makes texture uploads
+     * plain copies, instead of SDL repacking every frame (most backends store SDL_PIXELFORMAT_RGB24 as 32-bit).
+     *
+     * \param renderer SDL_Renderer instance the movie is drawn with
+     * \param alpha True if the format must have an alpha channel, e.g. for videos with alpha (see GleedMovieTrack video_alpha)
+     *
+     * \returns Pixel format, or SDL_PIXELFORMAT_UNKNOWN if none of the renderer formats can be converted to
+     * or on error. SDL_PIXELFORMAT_UNKNOWN passed to GleedSetVideoOutputFormat selects the default format.
+     */
+    extern SDL_PixelFormat GleedGetRendererVideoOutputFormat(SDL_Renderer *renderer, bool alpha);
+
     /**
      * Update playback texture with the current video frame
      *
@@ -290,6 +396,52 @@ extern "C"
      */
     extern bool GleedDecodeVideoFrame(GleedMovie *movie);
 
+    /**
+     * Decodes current video frame of the movie without producing any pixels.
+     *
+     * Use this for frames that will never be displayed (e.g. when catching up after a hitch):
+     * the codec state is updated, so following frames decode correctly, but the costly colour conversion is skipped
+     * and the video frame surface is left untouched.
+     *
+     * Where the bitstream allows it, non-reference (droppable) frames are skipped outright, without decoding.
+     * Such frames are counted in GleedMovieVideoStats::dropped_frames.
+     *
+     * As with GleedDecodeVideoFrame, you should call GleedNextVideoFrame afterwards.
+     *
+     * \param movie GleedMovie instance with configured video track
+     * \return True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSkipVideoFrame(GleedMovie *movie);
+
+    /**
+     * Decodes current video frame of the movie straight into your own pixel buffer
+     *
+     * Works as GleedDecodeVideoFrame, but the frame is converted right into the given memory
+     * (e.g. your texture staging buffer), so there is no copy out of the video frame surface,
+     * and that surface is never allocated if you only decode this way. The video frame surface is left untouched.
+     *
+     * The buffer must hold a frame of the size returned by GleedGetVideoSize. No particular alignment is required,
+     * pixels are written row by row and nothing past width * bytes per pixel of each row is touched,
+     * so the buffer may be a part of a larger image. The pitch must be at least width * bytes per pixel.
+     * The size is the one at the time of the call, so if you keep a buffer across GleedSetVideoOutputSize,
+     * GleedSetVideoCrop or a track change, make sure it still fits the new size. The pitch is checked on every call,
+     * the buffer height can't be, so a buffer that is too short is overflowed.
+     *
+     * Supported formats are the ones accepted by GleedSetVideoOutputFormat.
+     * Alpha of a video without alpha is written as opaque.
+     *
+     * Hidden frames (see GleedMovieVideoStats) produce no image, the buffer is left untouched then.
+     *
+     * As with GleedDecodeVideoFrame, you should call GleedNextVideoFrame afterwards.
+     *
+     * \param movie GleedMovie instance with configured video track
+     * \param pixels Buffer to write the frame to
+     * \param pitch Length of a buffer row in bytes
+     * \param format Pixel format of the buffer
+     * \return True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedDecodeVideoFrameInto(GleedMovie *movie, void *pixels, int pitch, SDL_PixelFormat format);
+
     /**
      * Get the current video frame surface
      *
@@ -301,15 +453,44 @@ extern "C"
      * If you are using SDL_Renderer, you may use GleedCreatePlaybackTexture and GleedUpdatePlaybackTexture functions
      * respectively to create and update a SDL_Texture for playback.
      *
-     * The format of the surface is SDL_PIXELFORMAT_RGB24, and the size is the same as the video frame size.
+     * The format of the surface is the video output format (see GleedSetVideoOutputFormat),
+     * and the size is the same as the video frame size.
      *
-     * The surface will be modified by the next call to GleedDecodeVideoFrame.
+     * The surface is created by the first call to GleedDecodeVideoFrame, and will be modified by the next one.
      *
      * \param movie GleedMovie instance with configured video track and decoded video frame
      * \return SDL_Surface instance with the video frame pixels, or NULL on error. Call GleedGetError to get the error message.
      */
     extern const SDL_Surface *GleedGetVideoFrameSurface(GleedMovie *movie);
 
+    /**
+     * Acquire the last decoded video frame in planar YUV form
+     *
+     * The frame points straight into the decoder frame buffer, which is kept out of reuse until you release it,
+     * so no pixels are copied for VP9 (VP8 decoder does not support external buffers, so its frames are copied once).
+     *
+     * This is useful if you want to upload YUV planes to the GPU yourself, e.g. with SDL_UpdateYUVTexture,
+     * or keep a few decoded frames around without converting them.
+     *
+     * Every acquired frame must be released with GleedReleaseVideoFrameYUV. Holding frames for a long time
+     * makes the decoder allocate new buffers instead of reusing them.
+     *
+     * \param movie GleedMovie instance with configured video track and decoded video frame
+     *
+     * \returns Decoded frame, or NULL if no frame is available (e.g. the last decoded frame was hidden) or on error.
+     * Call GleedGetError to get the error message.
+     */
+    extern const GleedVideoFrameYUV *GleedAcquireVideoFrameYUV(GleedMovie *movie);
+
+    /**
+     * Release a video frame acquired with GleedAcquireVideoFrameYUV
+     *
+     * Frame buffer returns to the decoder pool for reuse. It's safe to call this after the movie was freed.
+     *
+     * \param frame Frame to release, may be NULL
+     */
+    extern void GleedReleaseVideoFrameYUV(const GleedVideoFrameYUV *frame);
+
     /**
      * Move to the next video frame
      *
@@ -406,15 +587,75 @@ extern "C"
      * Seek to a specific frame in the movie
      *
      * This function allows you to seek to a specific video frame in the movie.
-     * The seek may be not precise, as it will seek to the nearest keyframe.
+     * The seek is frame accurate: the video decoder is restarted from the nearest preceding keyframe
+     * and frames up to the requested one are decoded (without colour conversion), so the next
+     * GleedDecodeVideoFrame call produces the requested frame.
+     *
+     * If the decoder is already positioned before the requested frame within the same group of pictures,
+     * decoding simply continues from there, so seeking forward by a few frames is cheap.
      *
-     * If both audio and video tracks are present, it will seek to the nearest keyframe of the video track
-     * and sync the audio track to the video track.
+     * If both audio and video tracks are present, the audio track is synced to the video track
+     * and the audio decoder state is reset.
      *
      * \param movie GleedMovie instance
      * \param frame Frame number to seek to
+     *
+     * \returns Number of frames that had to be decoded to reach the requested one, or -1 on error.
+     * Call GleedGetError to get the error message.
+     */
+    extern int GleedSeekFrame(GleedMovie *movie, Uint32 frame);
+
+    /**
+     * Show a specific video frame, for scrubbing and stepping through the movie in any direction
+     *
+     * Unlike GleedSeekFrame, the frame is decoded and converted right away, so it is available
+     * with GleedGetVideoFrameSurface when this function returns.
+     *
+     * Frames come from a cache of decoded groups of pictures: the group containing the frame is
+     * decoded once, on a background thread, and then kept as YUV images, so going back and forth
+     * within it only costs a colour conversion. The neighbouring group in the direction of scrubbing
+     * is decoded ahead of time, which makes reverse playback as smooth as forward playback.
+     * See GleedSetGOPCacheBudget for how much memory the cache may hold.
+     *
+     * Afterwards, the current frame of the movie is the shown one. GleedDecodeVideoFrame continues from there,
+     * and if both audio and video tracks are present, the audio track is synced to it.
+     *
+     * This function must not be used on a movie that a GleedMoviePlayer is decoding ahead for.
+     *
+     * \param movie GleedMovie instance
+     * \param frame Frame number to show
+     *
+     * \returns true on success, false on failure. Call GleedGetError to get the error message.
      */
-    extern void GleedSeekFrame(GleedMovie *movie, Uint32 frame);
+    extern bool GleedScrubToFrame(GleedMovie *movie, Uint32 frame);
+
+    /**
+     * Step a number of frames forwards or backwards from the current frame
+     *
+     * Same as calling GleedScrubToFrame with the current frame plus delta,
+     * so GleedStepFrame(movie, -1) shows the previous frame.
+     *
+     * \param movie GleedMovie instance
+     * \param delta Number of frames to step, negative to step backwards
+     *
+     * \returns true on success, false on failure or if the frame is outside of the movie.
+     * Call GleedGetError to get the error message.
+     */
+    extern bool GleedStepFrame(GleedMovie *movie, int delta);
+
+    /**
+     * Set how much memory the scrubbing cache of a movie may hold
+     *
+     * Decoded groups of pictures farthest from the last scrubbed frame are dropped first
+     * when the budget is exceeded. The group containing the last scrubbed frame is always kept,
+     * even if it alone exceeds the budget. The default is 192 MiB.
+     *
+     * \param movie GleedMovie instance
+     * \param bytes Budget in bytes, 0 to use the default
+     *
+     * \returns true on success, false on failure. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetGOPCacheBudget(GleedMovie *movie, size_t bytes);
 
     /**
      * Get the last frame decode time in milliseconds
@@ -428,6 +669,68 @@ extern "C"
      */
     extern Uint32 GleedGetLastFrameDecodeTime(GleedMovie *movie);
 
+    /**
+     * Get the last frame decode time in nanoseconds
+     *
+     * Same as GleedGetLastFrameDecodeTime, but precise enough for small frames, which decode well under a millisecond.
+     *
+     * \param movie GleedMovie instance
+     *
+     * \returns Time in nanoseconds, 0 if no frame was decoded yet or on error.
+     */
+    extern Uint64 GleedGetLastFrameDecodeTimeNS(GleedMovie *movie);
+
+    /**
+     * Get video decoding statistics of the movie
+     *
+     * \param movie GleedMovie instance
+     * \param stats Pointer to store the statistics to
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedGetVideoStats(GleedMovie *movie, GleedMovieVideoStats *stats);
+
+    /**
+     * Set video decode quality
+     *
+     * Lower quality makes each frame cheaper, so slow machines can hold the frame rate on heavy scenes.
+     * May be changed at any time, even during playback; it applies from the next decoded frame.
+     *
+     * GLEED_VIDEO_QUALITY_FAST only affects conversion: scaled output (see GleedSetVideoOutputSize)
+     * is point sampled instead of filtered, and 10/12-bit video is rounded instead of dithered.
+     *
+     * GLEED_VIDEO_QUALITY_FASTEST additionally skips the VP9 deblocking filter, which is a large part of VP9 decode time.
+     * As deblocked frames are references for the following ones, blockiness builds up until the next keyframe.
+     * VP8 has no such control in libvpx (and post-processing is never enabled), so VP8 only gets the faster conversion.
+     *
+     * To see the effect, GleedGetVideoDecodeTimeDelta compares the average decode time of frames decoded
+     * with a given quality to the full quality ones, and convert_ns of GleedGetVideoStats per converted frame
+     * can be compared before and after switching.
+     *
+     * Groups of pictures cached for scrubbing (see GleedScrubToFrame) are dropped when the quality changes.
+     *
+     * \param movie GleedMovie instance
+     * \param quality Decode quality
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoDecodeQuality(GleedMovie *movie, GleedVideoDecodeQuality quality);
+
+    /**
+     * Get how much faster (or slower) frames decode with the given quality than with full quality
+     *
+     * Averages the decode time of frames decoded with each quality in the given statistics,
+     * taken with GleedGetVideoStats or GleedGetPlayerVideoStats, so both qualities must have been used for at least one frame.
+     * Negative delta means the given quality is faster.
+     *
+     * \param stats Statistics to compute the delta from
+     * \param quality Decode quality to compare to GLEED_VIDEO_QUALITY_FULL
+     * \param delta_ns Pointer to store the difference of average per-frame decode times to, in nanoseconds
+     *
+     * \returns True on success, false on error or if there are no samples yet. Call GleedGetError to get the error message.
+     */
+    extern bool GleedGetVideoDecodeTimeDelta(const GleedMovieVideoStats *stats, GleedVideoDecodeQuality quality, Sint64 *delta_ns);
+
     /**
      * Get the total number of video frames in the movie
      *
@@ -449,7 +752,8 @@ extern "C"
     /**
      * Get the video size of the movie
      *
-     * This function returns the width and height of the video frames in the movie, in pixels.
+     * This function returns the width and height of the converted video frames in the movie, in pixels.
+     * That is the track size minus its crop, unless an output size was set with GleedSetVideoOutputSize.
      * Movie must have a video track selected.
      *
      * If there is an error, width and height parameters will not be changed.
@@ -460,6 +764,259 @@ extern "C"
      */
     extern void GleedGetVideoSize(GleedMovie *movie, int *w, int *h);
 
+    /**
+     * Set the size of converted video frames
+     *
+     * Decoded frames are scaled to this size while they are converted to RGB, in the same pass,
+     * so showing a movie in a small window costs conversion and upload of only the pixels you need.
+     * Scaling is bilinear, or averages source pixels (box filter) when downscaling by 2 or more.
+     *
+     * Video frame surface is recreated with the new size, so textures created with GleedCreatePlaybackTexture
+     * before this call no longer match. If you use GleedMoviePlayer, set the size before creating it.
+     *
+     * \param movie GleedMovie instance with configured video track
+     * \param w Width of converted frames, or 0 together with h to use the cropped track size (default)
+     * \param h Height of converted frames, or 0 together with w to use the cropped track size (default)
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoOutputSize(GleedMovie *movie, int w, int h);
+
+    /**
+     * Set the part of the video frame that is converted
+     *
+     * Only the pixels inside the crop rectangle are converted, scaled to the output size if one was set.
+     * By default, the crop from the track (Matroska PixelCrop elements) is used, usually the whole frame.
+     *
+     * Same as with GleedSetVideoOutputSize, the video frame surface is recreated if its size changes.
+     *
+     * \param movie GleedMovie instance with configured video track
+     * \param crop Crop rectangle in track pixels, or NULL to use the crop from the track
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoCrop(GleedMovie *movie, const SDL_Rect *crop);
+
+    /**
+     * Set the pixel format of converted video frames
+     *
+     * By default, frames are converted to SDL_PIXELFORMAT_RGB24, or SDL_PIXELFORMAT_RGBA32 for videos with alpha.
+     * Frames are converted straight to the chosen format, so picking the one your renderer stores natively
+     * (see GleedGetRendererVideoOutputFormat) saves SDL a repacking pass on every texture upload.
+     *
+     * Supported formats are SDL_PIXELFORMAT_RGB24 and SDL_PIXELFORMAT_BGR24, and 32-bit formats with 8 bits per channel:
+     * SDL_PIXELFORMAT_RGBA32, SDL_PIXELFORMAT_BGRA32, SDL_PIXELFORMAT_ARGB32, SDL_PIXELFORMAT_ABGR32 and their
+     * X variants without alpha, together with the packed aliases such as SDL_PIXELFORMAT_XRGB8888 or SDL_PIXELFORMAT_ARGB8888.
+     * Alpha of a video without alpha is written as opaque, and alpha of a video converted to a format without alpha is dropped.
+     *
+     * The format may be set before a video track is selected, and then applies to every track selected later.
+     * Same as with GleedSetVideoOutputSize, the video frame surface is recreated if its format changes,
+     * so if you use GleedMoviePlayer, set the format before creating it.
+     *
+     * \param movie GleedMovie instance
+     * \param format Pixel format, or SDL_PIXELFORMAT_UNKNOWN to use the default one
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoOutputFormat(GleedMovie *movie, SDL_PixelFormat format);
+
+    /**
+     * Get the pixel format of converted video frames
+     *
+     * \param movie GleedMovie instance with configured video track
+     *
+     * \returns Pixel format, or SDL_PIXELFORMAT_UNKNOWN if no video track is selected or on error.
+     */
+    extern SDL_PixelFormat GleedGetVideoOutputFormat(GleedMovie *movie);
+
+    /**
+     * Generate a mip chain along with every converted video frame
+     *
+     * Meant for movies drawn on in-world surfaces, where textures need mipmaps not to shimmer.
+     * Levels are box filtered, each one half the size of the previous (rounded down, at least 1 pixel),
+     * down to 1x1. They are filled in the conversion pass itself, from rows that were just written
+     * and are still in cache, so no extra read of the frame is needed.
+     *
+     * Levels are attached to the converted surface as alternate images, in the same pixel format.
+     * Get them with SDL_GetSurfaceImages on the surface returned by GleedGetVideoFrameSurface
+     * or GleedGetPlayerCurrentVideoFrameSurface: the first image is the frame itself, the levels follow, largest first.
+     *
+     * Frames decoded into your own buffers (GleedDecodeVideoFrameInto) or into player output textures get no mip levels.
+     * Set this before creating a GleedMoviePlayer for the movie.
+     *
+     * \param movie GleedMovie instance
+     * \param enabled True to generate mip levels, false to stop (default)
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoMipmapsEnabled(GleedMovie *movie, bool enabled);
+
+    /**
+     * Set a colour transform applied to converted video frames
+     *
+     * Colour matrix, lookup table and fade (see GleedColorTransform) are applied inside the conversion from YUV,
+     * on pixels that are still in registers and cache, so colour grading, brightness or gamma settings and fades
+     * cost no extra pass over the frame. The transform is copied, it may be changed every frame, e.g. to animate a fade.
+     *
+     * Transformed frames are not shared through the frame cache (see GleedSetVideoFrameCacheEnabled).
+     * Frames already converted ahead by a GleedMoviePlayer keep the transform they were converted with.
+     *
+     * \param movie GleedMovie instance
+     * \param transform Colour transform, or NULL to remove it
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoColorTransform(GleedMovie *movie, const GleedColorTransform *transform);
+
+    /**
+     * Fill the lookup table of a colour transform with a gamma curve
+     *
+     * Each channel value v becomes 255 * (v / 255) ^ (1 / gamma), so values above 1 brighten mid-tones
+     * and values below 1 darken them. Also enables the lookup table stage.
+     *
+     * \param transform Colour transform to fill
+     * \param gamma Gamma, greater than 0
+     */
+    extern void GleedSetColorTransformGamma(GleedColorTransform *transform, float gamma);
+
+    /**
+     * Choose between straight and premultiplied alpha for videos with alpha
+     *
+     * WebM stores alpha as a second VP8/VP9 stream, which is decoded in parallel with the colour one
+     * and merged into RGBA32 frames during conversion. By default colour is straight (not premultiplied).
+     * Has no effect on videos without alpha.
+     *
+     * Textures created with GleedCreatePlaybackTexture before this call keep their old blend mode.
+     *
+     * \param movie GleedMovie instance
+     * \param premultiplied True to premultiply colour by alpha
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoPremultipliedAlpha(GleedMovie *movie, bool premultiplied);
+
+    /**
+     * Share converted video frames with other instances of the same movie
+     *
+     * Useful when one movie is shown in several places at once, each with its own GleedMovie
+     * (e.g. the same looping background in several UI panels). With the cache enabled, every converted frame
+     * is kept in a process-wide cache, keyed by file, track, frame and conversion settings (crop, output size,
+     * alpha and quality). An instance reaching a frame another one has already converted copies it from the cache
+     * instead of decoding it; its decoder catches up from the last decoded frame or the keyframe once it reaches
+     * a frame that is not cached, so instances running far apart gain nothing.
+     *
+     * Instances of the same file are recognised by a fingerprint of the parsed frame index, so each may be opened
+     * from its own path or SDL_IOStream. Frames are shared only between instances that have the cache enabled
+     * and use the same conversion settings.
+     *
+     * Frames taken from the cache have no YUV planes, GleedAcquireVideoFrameYUV fails for them.
+     * Cached frames are counted in GleedMovieVideoStats::cache_hits.
+     *
+     * \param movie GleedMovie instance
+     * \param enabled True to use the frame cache
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetVideoFrameCacheEnabled(GleedMovie *movie, bool enabled);
+
+    /**
+     * Set memory limit of the frame cache
+     *
+     * Least recently used frames are evicted to keep the cache within the limit. Default is 64 MiB.
+     * Frames currently in use by a movie are freed once it is done with them.
+     *
+     * \param bytes Maximum memory taken by cached frame pixels, 0 to cache nothing
+     */
+    extern void GleedSetVideoFrameCacheLimit(size_t bytes);
+
+    /**
+     * Free all frames in the frame cache
+     *
+     * Cache lives as long as the process, call this on shutdown if you want all memory back.
+     */
+    extern void GleedClearVideoFrameCache(void);
+
+    /**
+     * Set how many decoder contexts are kept for reuse after their movies are freed
+     *
+     * GleedFreeMovie resets the video and audio decoders of the movie and parks them in a process-wide pool,
+     * instead of destroying them. A movie opened later takes a matching decoder from the pool on its first frame,
+     * together with its allocated frame buffers, so chained cutscenes do not pay decoder setup again.
+     *
+     * When the pool is full, the least recently parked decoders are destroyed. Default limit is 4.
+     *
+     * \param count Maximum number of parked decoders, 0 to disable pooling
+     */
+    extern void GleedSetDecoderPoolLimit(int count);
+
+    /**
+     * Destroy all decoders parked in the decoder pool
+     *
+     * Pool lives as long as the process, call this on shutdown or after a burst of movies to get the memory back.
+     */
+    extern void GleedTrimDecoderPool(void);
+
+    /**
+     * Extract thumbnails (poster frames) at given times of the movie
+     *
+     * For each time, only the keyframe nearest to it is decoded, so thumbnails are approximate
+     * by up to half a group of pictures. Keyframes are decoded in parallel, each thread with its own decoder,
+     * and converted straight to the thumbnail size, with the current crop (see GleedSetVideoCrop).
+     * Times falling to the same keyframe get identical thumbnails, decoded once.
+     *
+     * Movie decoding state is not touched, so this may be called while the movie is being played back,
+     * even with decode-ahead enabled.
+     *
+     * \param movie GleedMovie instance with configured video track
+     * \param times_ms Array of count times in milliseconds, in any order
+     * \param count Number of thumbnails to extract
+     * \param w Width of thumbnails
+     * \param h Height of thumbnails
+     * \param out_surfaces Array of count surfaces, filled with RGB24 thumbnails. Caller must free them with SDL_DestroySurface.
+     *
+     * \returns True on success, false on error (no surfaces are returned then). Call GleedGetError to get the error message.
+     */
+    extern bool GleedExtractThumbnails(GleedMovie *movie, const Uint64 *times_ms, int count, int w, int h, SDL_Surface **out_surfaces);
+
+    /**
+     * Callback receiving frames decoded by GleedDecodeRange
+     *
+     * \param userdata Pointer passed to GleedDecodeRange
+     * \param frame Number of the decoded frame
+     * \param time_ms Presentation time of the frame in milliseconds
+     * \param surface Converted frame, valid only during the call
+     *
+     * \returns True to continue decoding, false to stop.
+     */
+    typedef bool (*GleedDecodeRangeCallback)(void *userdata, Uint32 frame, Uint64 time_ms, const SDL_Surface *surface);
+
+    /**
+     * Decode a range of video frames using all CPU cores
+     *
+     * Meant for offline processing (previews, contact sheets, per-frame analysis) of whole movies or large parts of them.
+     * The range is split at keyframes, and each group of pictures is decoded on its own decoder instance,
+     * with as many threads as there are CPU cores, so throughput scales with cores as long as the range spans
+     * several keyframes. Decoding starts at the keyframe before the first frame, frames before it are not reported.
+     *
+     * Frames are converted with the current output size, crop, alpha and quality settings and passed to the callback
+     * one at a time, never concurrently, but from any of the decoding threads (including the calling one).
+     * Within a group of pictures frames come in order, but groups are decoded in parallel,
+     * so frames from different groups come interleaved - use the frame number to put them in order.
+     * Hidden frames produce no image and are not reported.
+     *
+     * Movie decoding state is not touched, so this may be called while the movie is being played back,
+     * even with decode-ahead enabled.
+     *
+     * \param movie GleedMovie instance with configured video track
+     * \param first First frame of the range
+     * \param last Last frame of the range, inclusive
+     * \param callback Function called for each decoded frame
+     * \param userdata Pointer passed to the callback
+     *
+     * \returns True on success, or if the callback stopped decoding, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedDecodeRange(GleedMovie *movie, Uint32 first, Uint32 last, GleedDecodeRangeCallback callback, void *userdata);
+
     /**
      * Get the error message
      *
@@ -467,6 +1024,8 @@ extern "C"
      *
      * Currently, error is not cleared after retrieval or successful operation.
      *
+     * Errors are kept per thread, so this returns the last error set on the calling thread.
+     *
      * \returns Error message string, or NULL if there was no error.
      */
     extern const char *GleedGetError();
@@ -528,6 +1087,8 @@ extern "C"
      *
      * Helper method to create a player from a file path. See GleedCreatePlayer for more information.
      *
+     * The movie is opened by the player, so it is freed along with it by GleedFreePlayer.
+     *
      * \param path Path to the .webm file
      *
      * \returns Pointer to the player instance, or NULL on error. Call GleedGetError to get the error message.
@@ -539,6 +1100,9 @@ extern "C"
      *
      * Helper method to create a player from an SDL IO stream. See GleedCreatePlayer for more information.
      *
+     * The movie opened on the stream is freed along with the player by GleedFreePlayer,
+     * the stream itself is not closed.
+     *
      * \param io SDL IO stream for the .webm file
      *
      * \returns Pointer to the player instance, or NULL on error. Call GleedGetError to get the error message.
@@ -579,6 +1143,9 @@ extern "C"
      *
      * So it's strongly recommended to pass the texture created with GleedCreatePlaybackTexture here.
      *
+     * When decoding synchronously, frames are converted straight into locked texture memory.
+     * Consider GleedSetPlayerVideoOutputTextures instead, so the renderer does not wait on a texture still being drawn.
+     *
      * You may pass NULL to disable automatic texture update.
      *
      * \param player GleedMoviePlayer instance
@@ -590,15 +1157,101 @@ extern "C"
         GleedMoviePlayer *player,
         SDL_Texture *texture);
 
+/**
+ * Maximum number of textures in the player video output ring, see GleedSetPlayerVideoOutputTextures
+ */
+#define GLEED_PLAYER_MAX_OUTPUT_TEXTURES 3
+
+    /**
+     * Set player video output to a ring of textures owned by the player
+     *
+     * Player creates the given number of streaming textures (as GleedCreatePlaybackTexture does) and writes each new
+     * video frame into the next one. When decoding synchronously, frames are converted straight into locked texture
+     * memory, without any intermediate surface; with decode-ahead, the queued frame is uploaded with a single copy.
+     *
+     * With a single texture, the renderer may have to wait for the GPU to finish drawing the previous frame
+     * before the texture can be written again. Two or three textures avoid that stall,
+     * at the cost of more video memory.
+     *
+     * After each GleedUpdatePlayer reporting GLEED_PLAYER_UPDATE_VIDEO, render the texture returned by
+     * GleedGetPlayerVideoOutputTexture. Textures are destroyed by the player, do not destroy them yourself.
+     *
+     * Textures are created with the current output size. If you change it with GleedSetVideoOutputSize afterwards,
+     * frames are scaled to the texture size, so call this function again to recreate them.
+     *
+     * Replaces any texture set with GleedSetPlayerVideoOutputTexture, and any buffer set with GleedSetPlayerVideoOutputBuffer.
+     * Pass 0 as count to destroy the textures and disable texture output.
+     *
+     * While textures are used for output, GleedGetPlayerCurrentVideoFrameSurface is not updated.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param renderer SDL_Renderer to create textures with, may be NULL if count is 0
+     * \param count Number of textures, from 1 to GLEED_PLAYER_MAX_OUTPUT_TEXTURES, or 0 to disable texture output
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetPlayerVideoOutputTextures(
+        GleedMoviePlayer *player,
+        SDL_Renderer *renderer,
+        int count);
+
+    /**
+     * Get the player video output texture holding the current frame
+     *
+     * With GleedSetPlayerVideoOutputTextures, this is the texture to render after an update reporting GLEED_PLAYER_UPDATE_VIDEO,
+     * it changes from frame to frame. With GleedSetPlayerVideoOutputTexture, this is always the texture you have set.
+     *
+     * \param player GleedMoviePlayer instance
+     *
+     * \returns SDL_Texture holding the current frame, or NULL if texture output is not set or no frame was written yet.
+     */
+    extern SDL_Texture *GleedGetPlayerVideoOutputTexture(
+        GleedMoviePlayer *player);
+
+    /**
+     * Set player video output to your own pixel buffer
+     *
+     * Every frame the player shows is written into the given memory during GleedUpdatePlayer.
+     * When decoding synchronously, frames are converted straight into it, with no intermediate surface;
+     * with decode-ahead, the queued frame is copied into it once.
+     *
+     * Buffer requirements are the same as for GleedDecodeVideoFrameInto: frame size is the one returned by
+     * GleedGetVideoSize, no alignment is required and the pitch must be at least width * bytes per pixel.
+     * The buffer must stay valid until output is changed or the player is freed.
+     *
+     * The buffer is bound to the frame size at the time of this call. If the frame size changes later
+     * (GleedSetVideoOutputSize, GleedSetVideoCrop, a switch between player variants), buffer output is disabled
+     * and the next GleedUpdatePlayer that has a frame to write fails instead of writing past the buffer.
+     * Set the buffer again for the new size to resume output.
+     *
+     * Replaces any texture output set with GleedSetPlayerVideoOutputTexture or GleedSetPlayerVideoOutputTextures,
+     * and setting one of those disables buffer output. Pass NULL as pixels to disable buffer output.
+     *
+     * While a buffer is used for output, GleedGetPlayerCurrentVideoFrameSurface is not updated when decoding synchronously.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param pixels Buffer to write frames to, or NULL to disable buffer output
+     * \param pitch Length of a buffer row in bytes
+     * \param format Pixel format of the buffer, see GleedDecodeVideoFrameInto for supported ones
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetPlayerVideoOutputBuffer(
+        GleedMoviePlayer *player,
+        void *pixels,
+        int pitch,
+        SDL_PixelFormat format);
+
     /*
         Enum for player update result
     */
     typedef enum
     {
-        GLEED_PLAYER_UPDATE_NONE = 0,       /**< No update was performed */
-        GLEED_PLAYER_UPDATE_AUDIO = 1 << 1, /**< Audio samples were updated */
-        GLEED_PLAYER_UPDATE_VIDEO = 1 << 2, /**< Video frame was updated */
-        GLEED_PLAYER_UPDATE_ERROR = 1 << 3, /**< An error occurred during update */
+        GLEED_PLAYER_UPDATE_NONE = 0,        /**< No update was performed */
+        GLEED_PLAYER_UPDATE_AUDIO = 1 << 1,  /**< Audio samples were updated */
+        GLEED_PLAYER_UPDATE_VIDEO = 1 << 2,  /**< Video frame was updated */
+        GLEED_PLAYER_UPDATE_ERROR = 1 << 3,  /**< An error occurred during update */
+        GLEED_PLAYER_UPDATE_BEHIND = 1 << 4, /**< Update budget ran out with frames still due, the next update carries on */
     } GleedMoviePlayerUpdateResult;
 
     /**
@@ -622,6 +1275,9 @@ extern "C"
      *
      * Player may queue more audio samples than needed for the current frame in order to have a buffer for smoother experience.
      *
+     * With an update budget set by GleedSetPlayerUpdateBudget, video decoding stops once the budget is spent,
+     * and GLEED_PLAYER_UPDATE_BEHIND is reported if video frames are still due. Audio that is due is always decoded.
+     *
      * Returned value is a bitmask of GleedMoviePlayerUpdateResult values. On error, only GLEED_PLAYER_UPDATE_ERROR will be set.
      *
      * \param player GleedMoviePlayer instance
@@ -631,6 +1287,34 @@ extern "C"
      */
     extern GleedMoviePlayerUpdateResult GleedUpdatePlayer(GleedMoviePlayer *player, int time_delta_ms);
 
+    /**
+     * Limit the time a single GleedUpdatePlayer call may spend decoding
+     *
+     * After a stall (e.g. loading), an update has to catch up on everything that became due meanwhile,
+     * which may take far longer than a frame of your application.
+     * With a budget set, the update stops decoding once the budget is spent and reports GLEED_PLAYER_UPDATE_BEHIND,
+     * the following updates carry on from there. When the playhead is already past a keyframe,
+     * the frames before it are dropped without decoding, so the player catches up in as few updates as possible.
+     *
+     * At least one video frame is decoded per update, so playback always moves forward.
+     * Audio that is already due is always decoded in full, only the preload ahead of it is cut short.
+     * The budget is checked between frames, so a single slow frame may still overshoot it.
+     * Frames decoded ahead on the decoder thread (GleedSetPlayerDecodeAhead) do not count against the budget.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param budget_us Time budget in microseconds, or 0 for no limit (the default)
+     */
+    extern void GleedSetPlayerUpdateBudget(GleedMoviePlayer *player, Uint32 budget_us);
+
+    /**
+     * Get the update time budget of the player
+     *
+     * \param player GleedMoviePlayer instance
+     *
+     * \returns Budget in microseconds set with GleedSetPlayerUpdateBudget, 0 if updates are not limited
+     */
+    extern Uint32 GleedGetPlayerUpdateBudget(GleedMoviePlayer *player);
+
     /**
      * Get the player audio samples
      *
@@ -659,8 +1343,9 @@ extern "C"
      *
      * Please note, the surface is only valid until the next call to GleedUpdatePlayer - the values may be overwritten after that.
      *
-     * If you have set a video output with GleedSetPlayerVideoOutputTexture, the texture will be updated automatically with
-     * the contents of this surface and there is no need to call this function.
+     * If you have set a video output with GleedSetPlayerVideoOutputTexture or GleedSetPlayerVideoOutputTextures,
+     * frames are written to the texture directly and there is no need to call this function.
+     * When decoding synchronously, this surface is not updated at all in that case.
      *
      * The size of the surface is equal to movie's video track dimensions.
      *
@@ -693,6 +1378,26 @@ extern "C"
      */
     extern void GleedResumePlayer(GleedMoviePlayer *player);
 
+    /**
+     * Prepare the player, so playback starts without a hitch
+     *
+     * Sets up the video and audio decoders and their buffers, decodes and converts the first video frame due,
+     * and decodes enough audio to fill the audio device buffer. The first GleedUpdatePlayer afterwards only has
+     * to show the prepared frame, uploading it to the output texture if there is one.
+     *
+     * May be called from a loading thread, as no textures are touched, but nothing else may use the player
+     * or its movie until it returns. Typical use is to pause the player, prepare it while loading,
+     * and start playback with GleedResumePlayer. Call it after setting up outputs (texture, buffer, audio device),
+     * so decoded audio goes straight to the device and the frame is converted in the right format.
+     *
+     * With decode-ahead (GleedSetPlayerDecodeAhead), waits until the decoder thread has queued the first frame.
+     *
+     * \param player GleedMoviePlayer instance
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedPreparePlayer(GleedMoviePlayer *player);
+
     /**
      * Check if the player is paused
      *
@@ -735,6 +1440,38 @@ extern "C"
      */
     extern Uint64 GleedGetPlayerCurrentTime(GleedMoviePlayer *player);
 
+    /**
+     * Seek the player to a specific time in milliseconds
+     *
+     * Video is positioned exactly on the frame that is displayed at the given time: the decoder restarts from
+     * the nearest preceding keyframe, so the cost of a seek is bounded by one group of pictures, not the movie length.
+     * The frame itself is decoded and shown by the next GleedUpdatePlayer call.
+     *
+     * Audio is positioned on the audio frame containing the given time. Audio decoder state is reset and
+     * the frames before it are decoded and discarded - for Opus, as much as the track seek pre-roll requires.
+     * Samples queued before the seek are discarded, including those in the audio output stream.
+     *
+     * Paused state is kept, so you can seek a paused player and resume it later.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param time_ms Time in milliseconds since movie start
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSeekPlayer(GleedMoviePlayer *player, Uint64 time_ms);
+
+    /**
+     * Seek the player to a specific time in seconds
+     *
+     * Same as GleedSeekPlayer, but takes time in seconds.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param time_s Time in seconds since movie start
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSeekPlayerSeconds(GleedMoviePlayer *player, float time_s);
+
     /**
      * Check if the player has audio enabled
      *
@@ -787,17 +1524,260 @@ extern "C"
      */
     extern void GleedSetPlayerVideoEnabled(GleedMoviePlayer *player, bool enabled);
 
+    /**
+     * Player visibility, deciding how much video work is done while nobody looks at it
+     *
+     * See GleedSetPlayerVisibility.
+     */
+    typedef enum
+    {
+        GLEED_PLAYER_VISIBLE = 0,   /**< Every frame is decoded and written to the output, the default */
+        GLEED_PLAYER_HIDDEN = 1,    /**< Only frames other frames depend on are decoded, nothing is converted or uploaded */
+        GLEED_PLAYER_SUSPENDED = 2, /**< No video is decoded at all, only the playback position advances */
+    } GleedPlayerVisibility;
+
+    /**
+     * Set player visibility
+     *
+     * Meant for players which are off-screen, covered, or in a minimized window. Unlike pausing, audio keeps playing
+     * and the timeline keeps advancing, but video does less work:
+     *
+     * - GLEED_PLAYER_HIDDEN keeps decoding reference frames, so the player is back with the very next frame once
+     *   visible again. Frames are never converted, so output texture and buffer are not updated.
+     * - GLEED_PLAYER_SUSPENDED decodes nothing. When made visible again, the decoder catches up from the last
+     *   keyframe before the current position, which takes at most one group of pictures of decoding.
+     *
+     * GleedUpdatePlayer never reports GLEED_PLAYER_UPDATE_VIDEO while the player is not visible.
+     * Decode-ahead queue, if set with GleedSetPlayerDecodeAhead, is stopped while the player is not visible.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param visibility New visibility of the player
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetPlayerVisibility(GleedMoviePlayer *player, GleedPlayerVisibility visibility);
+
+    /**
+     * Get player visibility
+     *
+     * \param player GleedMoviePlayer instance
+     *
+     * \returns Visibility set with GleedSetPlayerVisibility, GLEED_PLAYER_VISIBLE by default
+     */
+    extern GleedPlayerVisibility GleedGetPlayerVisibility(GleedMoviePlayer *player);
+
+    /**
+     * Set a colour transform applied to the video frames of the player
+     *
+     * Same as GleedSetVideoColorTransform on the movie of the player, and kept across switches between variants
+     * (see GleedAddPlayerVariant). Meant for cutscene fades, brightness or gamma settings and colour-blind filters,
+     * it may be changed on every update.
+     *
+     * With decode-ahead (see GleedSetPlayerDecodeAhead), frames already waiting in the queue were converted
+     * with the previous transform, so a change shows up that many frames later.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param transform Colour transform, or NULL to remove it
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetPlayerColorTransform(GleedMoviePlayer *player, const GleedColorTransform *transform);
+
+    /**
+     * Get video decoding statistics of the player
+     *
+     * When the player falls behind, it decodes overdue frames without converting them, or drops them completely
+     * when possible - this function lets you see how often that happens.
+     *
+     * With decode-ahead (GleedSetPlayerDecodeAhead), the counters are the ones as of the last frame
+     * the decoder thread finished. Use this function rather than GleedGetVideoStats of the player movie then.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param stats Pointer to store the statistics to
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedGetPlayerVideoStats(GleedMoviePlayer *player, GleedMovieVideoStats *stats);
+
+/**
+ * Default number of frames that is reasonable to decode ahead with GleedSetPlayerDecodeAhead
+ */
+#define GLEED_PLAYER_DEFAULT_DECODE_AHEAD 4
+
+    /**
+     * Set player decode-ahead queue size
+     *
+     * By default, player decodes video frames synchronously inside GleedUpdatePlayer,
+     * so any decoding spike directly adds to your application frame time.
+     *
+     * With decode-ahead enabled, a background decoder thread fills a bounded queue of decoded and converted
+     * video frames ahead of the playhead, and GleedUpdatePlayer only picks the frame that is due for display.
+     * If the player falls behind, overdue frames are dropped from the queue and only the latest one is shown.
+     *
+     * Each queued frame holds a full video frame surface, so memory usage grows with the queue size.
+     * GLEED_PLAYER_DEFAULT_DECODE_AHEAD is a reasonable starting value.
+     *
+     * While decode-ahead is enabled, the decoder thread owns the video decoding state of the movie,
+     * so you must not call GleedDecodeVideoFrame, GleedNextVideoFrame or GleedSeekFrame on the movie yourself.
+     * Use GleedSeekPlayer instead, it restarts the decoder thread at the new position.
+     *
+     * It's recommended to call this function before the first call to GleedUpdatePlayer,
+     * as frames already queued are discarded when the queue is resized or disabled.
+     *
+     * If the decoder thread or its queue can't be created, here or when the player later restarts it,
+     * decode-ahead is turned off and the player decodes synchronously again.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param frames Maximum number of frames to decode ahead, or 0 to decode synchronously (default)
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedSetPlayerDecodeAhead(GleedMoviePlayer *player, int frames);
+
+/**
+ * Maximum number of variants a player may switch between, including the movie it was created with
+ */
+#define GLEED_PLAYER_MAX_VARIANTS 8
+
+    /**
+     * Register a variant of the player's movie
+     *
+     * A variant is the same content encoded differently, usually at a lower resolution: either another video track
+     * of the player's movie, or another opened movie. Once the player has variants, it measures how long each frame
+     * takes to decode and convert, and switches to a cheaper variant when that exceeds the frame budget
+     * (see GleedSetPlayerVariantBudget), or to a more expensive one when there is enough headroom for it.
+     * Cost of a variant is estimated from its frame size.
+     *
+     * Switches happen at keyframes of the new variant, so no frames have to be decoded twice.
+     * Playback time is kept, and audio continues from the new movie where the old one left off,
+     * so variant movies must have the same audio track (and the same audio format).
+     *
+     * Converted frames of every variant are scaled to the output size of the movie the player was created with,
+     * so output textures and buffers stay valid across switches. Variants must agree on having an alpha channel.
+     *
+     * The movie the player was created with is variant 0, variants are numbered in the order they are added.
+     * Variant movies are not freed with the player, and must not be used elsewhere while it plays them.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param mov Movie of the variant, may be the player's own movie
+     * \param video_track Index of the video track to play from the movie
+     *
+     * \returns True on success, false on error. Call GleedGetError to get the error message.
+     */
+    extern bool GleedAddPlayerVariant(GleedMoviePlayer *player, GleedMovie *mov, int video_track);
+
+    /**
+     * Get the variant the player currently plays
+     *
+     * \param player GleedMoviePlayer instance
+     *
+     * \returns Index of the variant, 0 for the movie the player was created with
+     */
+    extern int GleedGetPlayerVariant(GleedMoviePlayer *player);
+
+    /**
+     * Set the frame budget used to pick player variants
+     *
+     * When the time the current variant takes to decode and convert a frame, averaged over recent frames,
+     * goes above the budget, the player switches to a cheaper variant.
+     *
+     * \param player GleedMoviePlayer instance
+     * \param budget_us Budget in microseconds, or 0 to use the frame duration of the video (the default)
+     */
+    extern void GleedSetPlayerVariantBudget(GleedMoviePlayer *player, Uint32 budget_us);
+
     /**
      * Free the player
      *
      * This function must be called when you no longer need the player instance.
      *
-     * It will free all resources associated with the player, but NOT the movie instance attached to it.
+     * It will free all resources associated with the player, but NOT the movie instance attached to it,
+     * unless the player opened the movie itself (GleedCreatePlayerFromPath, GleedCreatePlayerFromIO).
      *
      * \param player GleedMoviePlayer instance
      */
     extern void GleedFreePlayer(GleedMoviePlayer *player);
 
+/**
+ * Maximum number of branches prepared by one GleedPlayerBranches set
+ */
+#define GLEED_MAX_PLAYER_BRANCHES 8
+
+    /*
+        Set of players prepared for the ways an interactive movie may continue
+
+        See GleedCreatePlayerBranches. Opaque structure, do not modify its members directly.
+    */
+    typedef struct GleedPlayerBranches GleedPlayerBranches;
+
+    /**
+     * Create a set of speculatively prepared players
+     *
+     * At a decision point of an interactive movie, opening the chosen clip only once the choice is made
+     * leaves a visible gap. Instead, add every clip that may follow to a branch set while the choice is pending:
+     * each one is opened, paused, and decodes its first group of pictures ahead along with the audio it starts with.
+     * Once the choice is made, GleedCommitPlayerBranch hands over the chosen player, ready to show its first
+     * frame on the very first update after GleedResumePlayer.
+     *
+     * Converted frames of all branches together are kept within the memory budget. Branches that don't fit
+     * their whole first group of pictures decode fewer frames ahead, at least the first frame is always prepared.
+     *
+     * \param memory_budget Bytes of converted video frames the branches may hold together
+     * \param audio_device Opened audio device the branches play to, or 0 for no audio output
+     *
+     * \returns Pointer to the branch set, or NULL on error. Call GleedGetError to get the error message.
+     */
+    extern GleedPlayerBranches *GleedCreatePlayerBranches(size_t memory_budget, SDL_AudioDeviceID audio_device);
+
+    /**
+     * Open a movie and prepare it as a branch
+     *
+     * Blocks until the first frame and the first audio samples are decoded,
+     * the rest of the first group of pictures is decoded ahead in the background.
+     *
+     * \param branches GleedPlayerBranches instance
+     * \param path Path to the .webm file
+     *
+     * \returns Index of the branch, or -1 on error. Call GleedGetError to get the error message.
+     */
+    extern int GleedAddPlayerBranch(GleedPlayerBranches *branches, const char *path);
+
+    /**
+     * Open a movie from SDL IO stream and prepare it as a branch
+     *
+     * Same as GleedAddPlayerBranch. The stream is not closed when the branch is freed.
+     *
+     * \param branches GleedPlayerBranches instance
+     * \param io SDL IO stream for the .webm file
+     *
+     * \returns Index of the branch, or -1 on error. Call GleedGetError to get the error message.
+     */
+    extern int GleedAddPlayerBranchFromIO(GleedPlayerBranches *branches, SDL_IOStream *io);
+
+    /**
+     * Take the chosen branch out of the set
+     *
+     * Takes constant time, nothing is decoded or freed - call GleedResumePlayer on the returned player
+     * exactly when its movie has to start. The player is yours from now on and must be freed with GleedFreePlayer,
+     * which frees its movie too. It keeps decoding a whole group of pictures ahead, which you may reduce
+     * with GleedSetPlayerDecodeAhead once its first frames are shown.
+     *
+     * Branches that were not chosen are freed with the set, free it once the transition is over.
+     *
+     * \param branches GleedPlayerBranches instance
+     * \param index Index of the branch returned by GleedAddPlayerBranch
+     *
+     * \returns Paused, prepared player of the branch, or NULL on error. Call GleedGetError to get the error message.
+     */
+    extern GleedMoviePlayer *GleedCommitPlayerBranch(GleedPlayerBranches *branches, int index);
+
+    /**
+     * Free the branch set, along with every branch that was not committed
+     *
+     * \param branches GleedPlayerBranches instance
+     */
+    extern void GleedFreePlayerBranches(GleedPlayerBranches *branches);
+
 #ifdef __cplusplus
 }
 #endif
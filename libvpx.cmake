@@ -19,7 +19,7 @@ ExternalProject_Add (vpx_dependency
     GIT_PROGRESS TRUE
     UPDATE_COMMAND  ""
     INSTALL_COMMAND ""
-    CONFIGURE_COMMAND ${LIBVPX_PREFIX}/src/configure --prefix=${CMAKE_INSTALL_PREFIX} --enable-multithread --enable-runtime-cpu-detect
+    CONFIGURE_COMMAND ${LIBVPX_PREFIX}/src/configure --prefix=${CMAKE_INSTALL_PREFIX} --enable-multithread --enable-runtime-cpu-detect --enable-vp9-highbitdepth
 )
 
 add_library(libvpx STATIC IMPORTED)
@@ -1,20 +1,63 @@
 #include "gleed_movie_internal.h"
 
-static char gleed_movie_error[1024] = {0};
+#define GLEED_ERROR_SIZE 1024
+
+/* Worker threads report errors too, so every thread gets its own message buffer */
+static SDL_TLSID gleed_movie_error;
 
 static int GleedCachedFrameComparator(const void *a, const void *b)
 {
     const CachedMovieFrame *frame_a = (const CachedMovieFrame *)a;
     const CachedMovieFrame *frame_b = (const CachedMovieFrame *)b;
 
-    return frame_a->timecode - frame_b->timecode;
+    if (frame_a->timecode != frame_b->timecode)
+    {
+        return frame_a->timecode < frame_b->timecode ? -1 : 1;
+    }
+
+    /*
+        Hidden frames usually share the timecode with the frame that follows them,
+        and qsort is not stable, so keep the file (decoding) order for such frames
+    */
+    if (frame_a->offset != frame_b->offset)
+    {
+        return frame_a->offset < frame_b->offset ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static char *GleedGetErrorBuffer(void)
+{
+    char *buffer = (char *)SDL_GetTLS(&gleed_movie_error);
+
+    if (buffer)
+        return buffer;
+
+    buffer = (char *)SDL_calloc(1, GLEED_ERROR_SIZE);
+
+    if (!buffer)
+        return NULL;
+
+    if (!SDL_SetTLS(&gleed_movie_error, buffer, SDL_free))
+    {
+        SDL_free(buffer);
+        return NULL;
+    }
+
+    return buffer;
 }
 
 bool GleedSetError(const char *fmt, ...)
 {
+    char *buffer = GleedGetErrorBuffer();
+
+    if (!buffer)
+        return false;
+
     va_list ap;
     va_start(ap, fmt);
-    SDL_vsnprintf(gleed_movie_error, sizeof(gleed_movie_error), fmt, ap);
+    SDL_vsnprintf(buffer, GLEED_ERROR_SIZE, fmt, ap);
     va_end(ap);
 
     return false;
@@ -22,7 +65,9 @@ bool GleedSetError(const char *fmt, ...)
 
 const char *GleedGetError()
 {
-    return gleed_movie_error;
+    const char *buffer = GleedGetErrorBuffer();
+
+    return buffer ? buffer : "Out of memory";
 }
 
 GleedMovie *GleedOpen(const char *file)
@@ -38,6 +83,76 @@ GleedMovie *GleedOpen(const char *file)
     return GleedOpenIO(stream);
 }
 
+Uint64 GleedHashBytes(Uint64 hash, const void *data, size_t size)
+{
+    const Uint8 *bytes = (const Uint8 *)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+/* FNV-1a over the parsed frame index: instances of the same file always agree, different files practically never */
+static Uint64 GleedComputeMovieFingerprint(GleedMovie *movie)
+{
+    Uint64 hash = GLEED_HASH_INIT;
+
+    const Sint64 io_size = SDL_GetIOSize(movie->io);
+    hash = GleedHashBytes(hash, &io_size, sizeof(io_size));
+
+    for (int i = 0; i < movie->ntracks; i++)
+    {
+        hash = GleedHashBytes(hash, &movie->count_cached_frames[i], sizeof(Uint32));
+
+        for (Uint32 f = 0; f < movie->count_cached_frames[i]; f++)
+        {
+            const CachedMovieFrame *frame = &movie->cached_frames[i][f];
+
+            hash = GleedHashBytes(hash, &frame->timecode, sizeof(frame->timecode));
+            hash = GleedHashBytes(hash, &frame->offset, sizeof(frame->offset));
+            hash = GleedHashBytes(hash, &frame->size, sizeof(frame->size));
+        }
+    }
+
+    return hash;
+}
+
+/* Index takes over the parsed buffers, movie fields keep pointing into them */
+static GleedMovieIndex *GleedCreateMovieIndex(GleedMovie *movie)
+{
+    GleedMovieIndex *index = (GleedMovieIndex *)SDL_calloc(1, sizeof(GleedMovieIndex));
+
+    if (!index)
+        return NULL;
+
+    SDL_SetAtomicInt(&index->refcount, 1);
+
+    for (int i = 0; i < movie->ntracks; i++)
+    {
+        index->cached_frames[i] = movie->cached_frames[i];
+        index->codec_private_data[i] = movie->tracks[i].codec_private_data;
+    }
+
+    return index;
+}
+
+static void GleedReleaseMovieIndex(GleedMovieIndex *index)
+{
+    if (!index || !SDL_AtomicDecRef(&index->refcount))
+        return;
+
+    for (int i = 0; i < MAX_GLEED_TRACKS; i++)
+    {
+        SDL_free(index->cached_frames[i]);
+        SDL_free(index->codec_private_data[i]);
+    }
+
+    SDL_free(index);
+}
+
 GleedMovie *GleedOpenIO(SDL_IOStream *io)
 {
     if (!io)
@@ -56,8 +171,17 @@ GleedMovie *GleedOpenIO(SDL_IOStream *io)
     movie->current_audio_track = GLEED_NO_TRACK;
     movie->current_video_track = GLEED_NO_TRACK;
 
+    movie->io_lock = SDL_CreateMutex();
+    if (!movie->io_lock)
+    {
+        GleedSetError("Failed to create movie IO lock: %s", SDL_GetError());
+        SDL_free(movie);
+        return NULL;
+    }
+
     if (!GleedParseWebM(movie))
     {
+        SDL_DestroyMutex(movie->io_lock);
         SDL_free(movie);
         return NULL;
     }
@@ -82,34 +206,106 @@ GleedMovie *GleedOpenIO(SDL_IOStream *io)
         }
     }
 
+    movie->fingerprint = GleedComputeMovieFingerprint(movie);
+    movie->index = GleedCreateMovieIndex(movie);
+
+    if (!movie->index)
+    {
+        GleedSetError("Failed to allocate memory for movie index");
+
+        for (int i = 0; i < movie->ntracks; i++)
+        {
+            SDL_free(movie->cached_frames[i]);
+            SDL_free(movie->tracks[i].codec_private_data);
+        }
+
+        GleedFreeMovie(movie, false);
+        return NULL;
+    }
+
     return movie;
 }
 
-void GleedFreeMovie(GleedMovie *movie, bool closeio)
+GleedMovie *GleedCloneMovie(GleedMovie *movie, SDL_IOStream *io)
 {
-    if (!movie)
-        return;
+    if (!movie || !io)
+    {
+        GleedSetError("Invalid arguments");
+        return NULL;
+    }
 
-    for (int i = 0; i < movie->ntracks; i++)
+    /* Original may be reading frames on its decoder thread right now */
+    SDL_LockMutex(movie->io_lock);
+    const Sint64 movie_io_size = SDL_GetIOSize(movie->io);
+    SDL_UnlockMutex(movie->io_lock);
+
+    /* Every frame offset in the index would be wrong for a different file */
+    if (SDL_GetIOSize(io) != movie_io_size)
+    {
+        GleedSetError("IO stream does not match the movie being cloned");
+        return NULL;
+    }
+
+    GleedMovie *clone = SDL_calloc(1, sizeof(GleedMovie));
+    if (!clone)
     {
-        SDL_free(movie->cached_frames[i]);
+        GleedSetError("Failed to allocate memory for movie");
+        return NULL;
+    }
 
-        if (movie->tracks[i].codec_private_data)
-        {
-            SDL_free(movie->tracks[i].codec_private_data);
-        }
+    clone->io = io;
+    clone->current_audio_track = GLEED_NO_TRACK;
+    clone->current_video_track = GLEED_NO_TRACK;
+
+    clone->io_lock = SDL_CreateMutex();
+    if (!clone->io_lock)
+    {
+        GleedSetError("Failed to create movie IO lock: %s", SDL_GetError());
+        SDL_free(clone);
+        return NULL;
     }
 
-    if (movie->conversion_video_frame_buffer)
+    /* Tracks are copied by value, frame tables and other parsed buffers are only referenced */
+    clone->ntracks = movie->ntracks;
+    SDL_memcpy(clone->tracks, movie->tracks, sizeof(clone->tracks));
+    SDL_memcpy(clone->count_cached_frames, movie->count_cached_frames, sizeof(clone->count_cached_frames));
+    SDL_memcpy(clone->cached_frames, movie->cached_frames, sizeof(clone->cached_frames));
+
+    clone->timecode_scale = movie->timecode_scale;
+    clone->fingerprint = movie->fingerprint;
+
+    clone->index = movie->index;
+    SDL_AtomicIncRef(&clone->index->refcount);
+
+    GleedSelectTrack(clone, GLEED_TRACK_TYPE_VIDEO, movie->current_video_track);
+    GleedSelectTrack(clone, GLEED_TRACK_TYPE_AUDIO, movie->current_audio_track);
+
+    if (clone->current_video_track != movie->current_video_track || clone->current_audio_track != movie->current_audio_track)
     {
-        SDL_free(movie->conversion_video_frame_buffer);
+        GleedSetError("Failed to select the tracks of the movie being cloned");
+        GleedFreeMovie(clone, false);
+        return NULL;
     }
 
+    return clone;
+}
+
+void GleedFreeMovie(GleedMovie *movie, bool closeio)
+{
+    if (!movie)
+        return;
+
+    GleedDestroyGOPCache(movie);
+    GleedReleaseColorTransform(movie->video_color);
+    GleedReleaseMovieIndex(movie->index);
+
     if (movie->encoded_video_frame)
     {
         SDL_free(movie->encoded_video_frame);
     }
 
+    SDL_free(movie->encoded_alpha_frame);
+
     if (movie->decoded_audio_frame)
     {
         SDL_free(movie->decoded_audio_frame);
@@ -120,12 +316,15 @@ void GleedFreeMovie(GleedMovie *movie, bool closeio)
         SDL_DestroySurface(movie->current_frame_surface);
     }
 
+    GleedReleaseFrameCacheEntry(movie->video_cache_hit);
+
     if (movie->encoded_audio_buffer)
     {
         SDL_free(movie->encoded_audio_buffer);
     }
 
     GleedCloseVorbis(movie);
+    GleedCloseOpus(movie);
     GleedCloseVPX(movie);
 
     if (closeio)
@@ -133,6 +332,8 @@ void GleedFreeMovie(GleedMovie *movie, bool closeio)
         SDL_CloseIO(movie->io);
     }
 
+    SDL_DestroyMutex(movie->io_lock);
+
     SDL_free(movie);
 }
 
@@ -144,12 +345,15 @@ SDL_Texture *GleedCreatePlaybackTexture(GleedMovie *movie, SDL_Renderer *rendere
         return NULL;
     }
 
+    int w = 0, h = 0;
+    GleedGetVideoOutputSize(movie, &w, &h);
+
     SDL_Texture *texture = SDL_CreateTexture(
         renderer,
-        SDL_PIXELFORMAT_RGB24,
+        movie->video_pixel_format,
         SDL_TEXTUREACCESS_STREAMING, /*The texture contents will be updated frequently*/
-        GleedGetVideoTrack(movie)->video_width,
-        GleedGetVideoTrack(movie)->video_height);
+        w,
+        h);
 
     if (!texture)
     {
@@ -157,10 +361,45 @@ SDL_Texture *GleedCreatePlaybackTexture(GleedMovie *movie, SDL_Renderer *rendere
         return NULL;
     }
 
+    if (SDL_ISPIXELFORMAT_ALPHA(movie->video_pixel_format))
+    {
+        /* Opaque video in a format with alpha (see GleedSetVideoOutputFormat) needs no blending */
+        if (!GleedGetVideoTrack(movie)->video_alpha)
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+        else
+            SDL_SetTextureBlendMode(texture, movie->video_premultiplied_alpha ? SDL_BLENDMODE_BLEND_PREMULTIPLIED : SDL_BLENDMODE_BLEND);
+    }
+
     return texture;
 }
 
-void GleedAddCachedFrame(GleedMovie *movie, Uint32 track, Uint64 timecode, Uint32 offset, Uint32 size, bool key_frame)
+SDL_PixelFormat GleedGetRendererVideoOutputFormat(SDL_Renderer *renderer, bool alpha)
+{
+    if (!renderer)
+    {
+        GleedSetError("Invalid renderer");
+        return SDL_PIXELFORMAT_UNKNOWN;
+    }
+
+    const SDL_PixelFormat *formats = (const SDL_PixelFormat *)SDL_GetPointerProperty(SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_TEXTURE_FORMATS_POINTER, NULL);
+
+    if (!formats)
+    {
+        GleedSetError("Failed to get renderer texture formats: %s", SDL_GetError());
+        return SDL_PIXELFORMAT_UNKNOWN;
+    }
+
+    /* Renderer lists its formats best first, the first one the converter can write is stored without repacking */
+    for (const SDL_PixelFormat *format = formats; *format != SDL_PIXELFORMAT_UNKNOWN; format++)
+    {
+        if (GleedIsVideoOutputFormatSupported(*format) && (!alpha || SDL_ISPIXELFORMAT_ALPHA(*format)))
+            return *format;
+    }
+
+    return SDL_PIXELFORMAT_UNKNOWN;
+}
+
+void GleedAddCachedFrame(GleedMovie *movie, Uint32 track, Uint64 timecode, Uint32 offset, Uint32 size, bool key_frame, bool hidden)
 {
     if (!movie)
         return;
@@ -192,6 +431,7 @@ void GleedAddCachedFrame(GleedMovie *movie, Uint32 track, Uint64 timecode, Uint3
     frame->offset = offset;
     frame->size = size;
     frame->key_frame = key_frame;
+    frame->hidden = hidden;
 
     /* We record the actual memory offset for each frame (accumulating the sizes of previous frames) */
     if (new_frame_index == 0)
@@ -213,6 +453,27 @@ void GleedAddCachedFrame(GleedMovie *movie, Uint32 track, Uint64 timecode, Uint3
     movie->tracks[track].total_bytes += size;
 }
 
+/* Alpha payload is only indexed, like the colour frame it is read from the file when decoded; data is only peeked at */
+bool GleedAddCachedFrameAlpha(GleedMovie *movie, Uint32 track, Uint32 frame, Uint64 offset, const Uint8 *data, Uint32 size)
+{
+    if (track >= movie->ntracks || frame >= movie->count_cached_frames[track])
+        return GleedSetError("Alpha payload of frame %u does not belong to an indexed frame", frame);
+
+    /* Frame offsets are 32-bit, like the ones of the colour frames */
+    if (offset + size > SDL_MAX_UINT32)
+        return GleedSetError("Alpha payload of frame %u is out of the supported file size", frame);
+
+    CachedMovieFrame *cached_frame = &movie->cached_frames[track][frame];
+
+    cached_frame->alpha_offset = (Uint32)offset;
+    cached_frame->alpha_size = size;
+
+    /* Decoding can only start where both streams restart, alpha GOPs are not guaranteed to match colour ones */
+    cached_frame->key_frame = cached_frame->key_frame && GleedIsVPXKeyFrame(GleedGetTrackCodec(&movie->tracks[track]), data, size);
+
+    return true;
+}
+
 int GleedFindTrackByNumber(GleedMovie *movie, Uint32 track_number)
 {
     for (int i = 0; i < movie->ntracks; i++)
@@ -225,6 +486,31 @@ int GleedFindTrackByNumber(GleedMovie *movie, Uint32 track_number)
     return -1;
 }
 
+Uint32 GleedFindFrameAtTimecode(GleedMovie *movie, int track, Uint64 timecode)
+{
+    const CachedMovieFrame *frames = movie->cached_frames[track];
+
+    /* Binary search for the last frame starting at or before the timecode, frames are sorted by timecode */
+    Uint32 low = 0;
+    Uint32 high = movie->count_cached_frames[track];
+
+    while (low < high)
+    {
+        const Uint32 mid = low + (high - low) / 2;
+
+        if (frames[mid].timecode <= timecode)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low > 0 ? low - 1 : 0;
+}
+
 bool GleedCanPlaybackVideo(GleedMovie *movie)
 {
     return movie && movie->ntracks > 0 && movie->total_frames > 0 && movie->current_video_track != GLEED_NO_TRACK;
@@ -235,7 +521,7 @@ bool GleedCanPlaybackAudio(GleedMovie *movie)
     return movie && movie->ntracks > 0 && movie->total_audio_frames > 0 && movie->current_audio_track != GLEED_NO_TRACK;
 }
 
-static GleedMovieCodecType GleedGetTrackCodec(GleedMovieTrack *track)
+GleedMovieCodecType GleedGetTrackCodec(const GleedMovieTrack *track)
 {
     if (SDL_strncmp(track->codec_id, "V_VP8", 32) == 0)
     {
@@ -259,6 +545,14 @@ static GleedMovieCodecType GleedGetTrackCodec(GleedMovieTrack *track)
     }
 }
 
+static SDL_PixelFormat GleedGetTrackVideoPixelFormat(const GleedMovie *movie, const GleedMovieTrack *track)
+{
+    if (movie->video_output_format != SDL_PIXELFORMAT_UNKNOWN)
+        return movie->video_output_format;
+
+    return track->video_alpha ? SDL_PIXELFORMAT_RGBA32 : SDL_PIXELFORMAT_RGB24;
+}
+
 void GleedSelectTrack(GleedMovie *movie, GleedMovieTrackType type, int track)
 {
     if (!movie)
@@ -274,6 +568,12 @@ void GleedSelectTrack(GleedMovie *movie, GleedMovieTrackType type, int track)
 
     if (type == GLEED_TRACK_TYPE_VIDEO)
     {
+        /* Cached groups of pictures belong to the previous track */
+        GleedDestroyGOPCache(movie);
+
+        /* So do the decoder references, flushed while video_codec still names the codec holding them */
+        GleedResetVPX(movie);
+
         movie->current_video_track = track;
 
         GleedMovieTrack *new_video_track = GleedGetVideoTrack(movie);
@@ -281,15 +581,11 @@ void GleedSelectTrack(GleedMovie *movie, GleedMovieTrackType type, int track)
         movie->video_codec = GleedGetTrackCodec(new_video_track);
         movie->total_frames = new_video_track->total_frames;
 
-        if (movie->current_frame_surface)
-        {
-            SDL_DestroySurface(movie->current_frame_surface);
-        }
+        /* Decoder is nowhere in the new track, the next decode catches up from a keyframe */
+        movie->decoder_next_frame = movie->total_frames;
+        movie->video_pixel_format = GleedGetTrackVideoPixelFormat(movie, new_video_track);
 
-        movie->current_frame_surface = SDL_CreateSurface(
-            new_video_track->video_width,
-            new_video_track->video_height,
-            SDL_PIXELFORMAT_RGB24);
+        GleedSetVideoCrop(movie, NULL);
     }
     else if (type == GLEED_TRACK_TYPE_AUDIO)
     {
@@ -329,85 +625,473 @@ bool GleedDecodeVideoFrame(GleedMovie *movie)
     if (!movie)
         return false;
 
-    if (!GleedCanPlaybackVideo(movie))
-    {
-        GleedSetError("No tracks or playback data available");
+    return GleedDecodeVideoFrameTo(movie, movie->current_frame_surface, GLEED_VIDEO_DECODE_CONVERT);
+}
+
+bool GleedSkipVideoFrame(GleedMovie *movie)
+{
+    if (!movie)
         return false;
+
+    return GleedDecodeVideoFrameTo(movie, NULL, GLEED_VIDEO_DECODE_ONLY | GLEED_VIDEO_DECODE_ALLOW_DROP);
+}
+
+static bool GleedIsCurrentVideoFrameDroppable(GleedMovie *movie)
+{
+    Uint8 next_header[4];
+    size_t next_header_size = 0;
+
+    /* VP9 frames may feed motion vectors into the next one, so we need a peek at its header */
+    if (movie->video_codec == GLEED_CODEC_TYPE_VP9 && movie->current_frame + 1 < movie->total_frames)
+    {
+        const CachedMovieFrame *next_frame = &movie->cached_frames[movie->current_video_track][movie->current_frame + 1];
+
+        next_header_size = SDL_min(sizeof(next_header), next_frame->size);
+
+        SDL_LockMutex(movie->io_lock);
+        SDL_SeekIO(movie->io, next_frame->offset, SDL_IO_SEEK_SET);
+        next_header_size = SDL_ReadIO(movie->io, next_header, next_header_size);
+        SDL_UnlockMutex(movie->io_lock);
     }
 
-    GleedMovieTrack *video_track = GleedGetVideoTrack(movie);
+    const bool droppable = GleedIsVPXFrameDroppable(
+        movie->video_codec,
+        movie->encoded_video_frame,
+        movie->encoded_video_frame_size,
+        next_header_size > 0 ? next_header : NULL,
+        next_header_size);
 
-    GleedReadCurrentFrame(movie, GLEED_TRACK_TYPE_VIDEO);
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+    const CachedMovieFrame *frame = &frames[movie->current_frame];
 
-    if (movie->video_codec == GLEED_CODEC_TYPE_VP8 || movie->video_codec == GLEED_CODEC_TYPE_VP9)
+    if (!droppable || frame->alpha_size == 0)
     {
-        return GleedDecodeVPX(movie);
+        return droppable;
     }
 
-    GleedSetError("Unsupported video codec, frame not decoded");
+    /* Alpha stream keeps its own references, so it has to be droppable as well */
+    const CachedMovieFrame *next_frame = movie->current_frame + 1 < movie->total_frames ? &frames[movie->current_frame + 1] : NULL;
 
-    return false;
+    Uint8 next_alpha_header[4];
+    size_t next_alpha_header_size = 0;
+
+    if (movie->video_codec == GLEED_CODEC_TYPE_VP9 && next_frame && next_frame->alpha_size > 0)
+    {
+        next_alpha_header_size = SDL_min(sizeof(next_alpha_header), next_frame->alpha_size);
+
+        SDL_LockMutex(movie->io_lock);
+        SDL_SeekIO(movie->io, next_frame->alpha_offset, SDL_IO_SEEK_SET);
+        next_alpha_header_size = SDL_ReadIO(movie->io, next_alpha_header, next_alpha_header_size);
+        SDL_UnlockMutex(movie->io_lock);
+    }
+
+    return GleedIsVPXFrameDroppable(
+        movie->video_codec,
+        movie->encoded_alpha_frame,
+        frame->alpha_size,
+        next_alpha_header_size > 0 ? next_alpha_header : NULL,
+        next_alpha_header_size);
 }
 
-bool GleedUpdatePlaybackTexture(GleedMovie *movie, SDL_Texture *texture)
+static void GleedGetFrameCacheKey(GleedMovie *movie, GleedFrameCacheKey *key)
 {
-    if (!movie || !texture)
+    SDL_zerop(key);
+
+    key->fingerprint = movie->fingerprint;
+    key->track = movie->current_video_track;
+    key->frame = movie->current_frame;
+    key->crop = movie->video_crop;
+    GleedGetVideoOutputSize(movie, &key->w, &key->h);
+    key->format = movie->video_pixel_format;
+    key->premultiply = movie->video_premultiplied_alpha;
+    key->quality = movie->frame_quality;
+}
+
+static bool GleedHasVideoColorTransform(GleedMovie *movie)
+{
+    SDL_LockSpinlock(&movie->video_color_lock);
+
+    const bool has_transform = movie->video_color != NULL;
+
+    SDL_UnlockSpinlock(&movie->video_color_lock);
+
+    return has_transform;
+}
+
+/* Decodes the current frame itself, whatever the frame cache holds */
+static bool GleedDecodeVideoFrameUncached(GleedMovie *movie, SDL_Surface *target, GleedVideoDecodeFlags flags)
+{
+    GleedReadCurrentFrame(movie, GLEED_TRACK_TYPE_VIDEO);
+
+    /* Transparent frame can't be decoded without its alpha, that would show it opaque */
+    if (GleedGetCurrentCachedFrame(movie, GLEED_TRACK_TYPE_VIDEO)->alpha_size > 0 &&
+        !GleedReadVideoAlphaPacket(movie, movie->current_frame, &movie->encoded_alpha_frame, &movie->encoded_alpha_frame_capacity))
     {
-        GleedSetError("movie and texture cannot be NULL");
         return false;
     }
 
-    if (!movie->current_frame_surface)
+    if ((flags & GLEED_VIDEO_DECODE_ALLOW_DROP) && GleedIsCurrentVideoFrameDroppable(movie))
     {
-        GleedSetError("No frame available, you must decode a frame first");
-        return false;
+        movie->video_frame_shown = false;
+        movie->video_stats.dropped_frames++;
+        movie->decoder_next_frame = movie->current_frame + 1;
+        return true;
     }
 
-    if (texture->format != movie->current_frame_surface->format)
+    if (movie->video_codec == GLEED_CODEC_TYPE_VP8 || movie->video_codec == GLEED_CODEC_TYPE_VP9)
     {
-        GleedSetError("Texture format does not match video frame format, provided = %d, required = %d",
-                      texture->format, movie->current_frame_surface->format);
-        return false;
+        if (!GleedDecodeVPX(movie, target, flags))
+        {
+            return false;
+        }
+
+        movie->decoder_next_frame = movie->current_frame + 1;
+
+        return true;
     }
 
-    SDL_Surface *target;
-    SDL_LockTextureToSurface(texture, NULL, &target);
-    SDL_BlitSurface(movie->current_frame_surface, NULL, target, NULL);
-    SDL_UnlockTexture(texture);
+    GleedSetError("Unsupported video codec, frame not decoded");
 
-    return true;
+    return false;
 }
 
-void GleedReadCurrentFrame(GleedMovie *movie, GleedMovieTrackType type)
+/*
+    Decoder references only match the frame following the last decoded one.
+    If that frame lies between the keyframe and the target, we just keep decoding from there,
+    otherwise the decoder has to start over from the keyframe. Leaves the movie positioned on the target frame.
+*/
+bool GleedCatchUpVideoDecoder(GleedMovie *movie, Uint32 frame)
 {
-    if (!movie)
-        return;
+    const Uint32 key_frame = GleedFindVideoKeyFrame(movie, frame);
 
-    int target_track_index = type == GLEED_TRACK_TYPE_VIDEO ? movie->current_video_track : movie->current_audio_track;
+    if (movie->decoder_next_frame < key_frame || movie->decoder_next_frame > frame)
+    {
+        GleedResetVPX(movie);
+        movie->decoder_next_frame = key_frame;
+    }
 
-    if (target_track_index == GLEED_NO_TRACK)
+    for (movie->current_frame = movie->decoder_next_frame; movie->current_frame < frame; movie->current_frame++)
     {
-        return;
+        if (!GleedDecodeVideoFrameUncached(movie, NULL, GLEED_VIDEO_DECODE_ONLY | GLEED_VIDEO_DECODE_ALLOW_DROP))
+        {
+            /* Decoder state is unknown now, so the next catch up starts over from a keyframe */
+            movie->decoder_next_frame = movie->total_frames;
+            movie->current_frame = frame;
+            return false;
+        }
     }
 
-    if (type == GLEED_TRACK_TYPE_VIDEO)
+    return true;
+}
+
+bool GleedDecodeVideoFrameTo(GleedMovie *movie, SDL_Surface *target, GleedVideoDecodeFlags flags)
+{
+    if (!movie)
+        return false;
+
+    if (!GleedCanPlaybackVideo(movie))
     {
-        CachedMovieFrame *frame = &movie->cached_frames[target_track_index][movie->current_frame];
+        GleedSetError("No tracks or playback data available");
+        return false;
+    }
 
-        if (!movie->encoded_video_frame || movie->encoded_video_frame_size < frame->size)
+    /* Quality may be changed on another thread meanwhile, the whole frame is decoded, converted and cached with this one */
+    movie->frame_quality = GleedGetVideoDecodeQuality(movie);
+
+    /* Cached image of the previous frame is no longer current */
+    GleedReleaseFrameCacheEntry(movie->video_cache_hit);
+    movie->video_cache_hit = NULL;
+
+    /* Frames of other instances were converted without our colour transform */
+    if (!movie->video_cache_enabled || GleedHasVideoColorTransform(movie))
+    {
+        /* Scrubbing (GleedScrubToFrame) moves the position without touching the decoder, which has to catch up then */
+        if (movie->decoder_next_frame != movie->current_frame && !GleedCatchUpVideoDecoder(movie, movie->current_frame))
         {
-            movie->encoded_video_frame = SDL_realloc(movie->encoded_video_frame, frame->size);
+            return false;
         }
 
-        SDL_SeekIO(movie->io, frame->offset, SDL_IO_SEEK_SET);
+        return GleedDecodeVideoFrameUncached(movie, target, flags);
+    }
 
-        SDL_ReadIO(movie->io, movie->encoded_video_frame, frame->size);
+    /*
+        Frames that are not converted, and hidden ones which have no image to share, are decoded only once
+        the decoder has to catch up - the following frames may well come from the cache.
+    */
+    const bool convert = flags & (GLEED_VIDEO_DECODE_CONVERT | GLEED_VIDEO_DECODE_CONVERT_LATER);
 
-        movie->encoded_video_frame_size = frame->size;
+    if (!convert || movie->cached_frames[movie->current_video_track][movie->current_frame].hidden)
+    {
+        movie->video_frame_shown = false;
+        return true;
+    }
+
+    GleedFrameCacheKey key;
+    GleedGetFrameCacheKey(movie, &key);
+
+    /* Another instance has converted this frame already; our decoder stays behind and catches up on the next miss */
+    movie->video_cache_hit = GleedAcquireFrameCacheEntry(&key);
+
+    if (movie->video_cache_hit)
+    {
+        movie->video_frame_shown = true;
+        movie->video_stats.cache_hits++;
     }
     else
     {
-        CachedMovieFrame *frame = &movie->cached_frames[target_track_index][movie->current_audio_frame];
+        if (movie->decoder_next_frame != movie->current_frame && !GleedCatchUpVideoDecoder(movie, movie->current_frame))
+        {
+            return false;
+        }
+
+        const GleedVideoDecodeFlags decode_flags = (GleedVideoDecodeFlags)((flags & ~GLEED_VIDEO_DECODE_CONVERT) | GLEED_VIDEO_DECODE_CONVERT_LATER);
+
+        if (!GleedDecodeVideoFrameUncached(movie, target, decode_flags))
+        {
+            return false;
+        }
+    }
+
+    if (!(flags & GLEED_VIDEO_DECODE_CONVERT) || !movie->video_frame_shown)
+    {
+        return true;
+    }
+
+    return GleedConvertVideoFrameTo(movie, target);
+}
+
+static bool GleedCopyCachedVideoFrame(GleedMovie *movie, SDL_Surface *target)
+{
+    const SDL_Surface *cached = movie->video_cache_hit->surface;
+
+    if (!target)
+    {
+        target = GleedEnsureVideoFrameSurface(movie);
+
+        if (!target)
+            return false;
+    }
+
+    /* Cached frame does not fit the target, so it has to be decoded after all */
+    if (target->w != cached->w || target->h != cached->h)
+    {
+        GleedReleaseFrameCacheEntry(movie->video_cache_hit);
+        movie->video_cache_hit = NULL;
+
+        if (!GleedCatchUpVideoDecoder(movie, movie->current_frame) ||
+            !GleedDecodeVideoFrameUncached(movie, NULL, GLEED_VIDEO_DECODE_CONVERT_LATER))
+        {
+            return false;
+        }
+
+        return GleedConvertVideoFrameTo(movie, target);
+    }
+
+    if (!SDL_ConvertPixels(cached->w, cached->h, cached->format, cached->pixels, cached->pitch, target->format, target->pixels, target->pitch))
+    {
+        return GleedSetError("Failed to copy cached video frame: %s", SDL_GetError());
+    }
+
+    /* Cache shares only the full size image, levels are rebuilt from the copy while it is still warm */
+    if (movie->video_mipmaps && !(target->flags & SDL_SURFACE_PREALLOCATED))
+    {
+        return GleedGenerateSurfaceMipmaps(target);
+    }
+
+    return true;
+}
+
+bool GleedConvertVideoFrameTo(GleedMovie *movie, SDL_Surface *target)
+{
+    if (movie->video_cache_hit)
+    {
+        return GleedCopyCachedVideoFrame(movie, target);
+    }
+
+    if (movie->video_codec != GLEED_CODEC_TYPE_VP8 && movie->video_codec != GLEED_CODEC_TYPE_VP9)
+    {
+        return GleedSetError("Unsupported video codec, frame not converted");
+    }
+
+    if (!GleedConvertVPX(movie, target))
+    {
+        return false;
+    }
+
+    if (movie->video_cache_enabled && !movie->video_frame_transformed)
+    {
+        GleedFrameCacheKey key;
+        GleedGetFrameCacheKey(movie, &key);
+
+        const SDL_Surface *converted = target ? target : movie->current_frame_surface;
+
+        /* Only frames converted the default way are shared, as that is how every instance looks them up */
+        if (converted->w == key.w && converted->h == key.h && converted->format == key.format)
+        {
+            GleedAddFrameCacheEntry(&key, converted);
+        }
+    }
+
+    return true;
+}
+
+bool GleedCheckVideoOutputBuffer(GleedMovie *movie, const void *pixels, int pitch, SDL_PixelFormat format)
+{
+    if (!pixels)
+        return GleedSetError("Invalid output buffer");
+
+    if (!GleedIsVideoOutputFormatSupported(format))
+        return GleedSetError("Unsupported output pixel format: %s", SDL_GetPixelFormatName(format));
+
+    int w, h;
+    GleedGetVideoOutputSize(movie, &w, &h);
+
+    if (pitch < w * SDL_BYTESPERPIXEL(format))
+        return GleedSetError("Output buffer pitch %d is too small for %d pixels wide frames", pitch, w);
+
+    return true;
+}
+
+bool GleedConvertVideoFrameToPixels(GleedMovie *movie, void *pixels, int pitch, SDL_PixelFormat format)
+{
+    int w, h;
+    GleedGetVideoOutputSize(movie, &w, &h);
+
+    /* Only the surface header is allocated, pixels are written right into caller memory */
+    SDL_Surface *target = SDL_CreateSurfaceFrom(w, h, format, pixels, pitch);
+
+    if (!target)
+        return GleedSetError("Failed to wrap output buffer: %s", SDL_GetError());
+
+    const bool converted = GleedConvertVideoFrameTo(movie, target);
+
+    SDL_DestroySurface(target);
+
+    return converted;
+}
+
+bool GleedDecodeVideoFrameInto(GleedMovie *movie, void *pixels, int pitch, SDL_PixelFormat format)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    if (!GleedCanPlaybackVideo(movie))
+        return GleedSetError("No tracks or playback data available");
+
+    if (!GleedCheckVideoOutputBuffer(movie, pixels, pitch, format))
+        return false;
+
+    if (!GleedDecodeVideoFrameTo(movie, NULL, GLEED_VIDEO_DECODE_CONVERT_LATER))
+        return false;
+
+    /* Hidden frames have no image, caller keeps what was in the buffer */
+    if (!movie->video_frame_shown)
+        return true;
+
+    return GleedConvertVideoFrameToPixels(movie, pixels, pitch, format);
+}
+
+bool GleedIsVideoFrameSuperseded(GleedMovie *movie, Uint64 time)
+{
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    /* Current frame is superseded if any later visible frame is already due at the given time */
+    for (Uint32 frame = movie->current_frame + 1; frame < movie->total_frames; frame++)
+    {
+        if (GleedTimecodeToMilliseconds(movie, frames[frame].timecode) > time)
+        {
+            return false;
+        }
+
+        if (!frames[frame].hidden)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool GleedGetVideoStats(GleedMovie *movie, GleedMovieVideoStats *stats)
+{
+    if (!movie || !stats)
+    {
+        return GleedSetError("movie and stats cannot be NULL");
+    }
+
+    *stats = movie->video_stats;
+
+    return true;
+}
+
+bool GleedUpdatePlaybackTexture(GleedMovie *movie, SDL_Texture *texture)
+{
+    if (!movie || !texture)
+    {
+        GleedSetError("movie and texture cannot be NULL");
+        return false;
+    }
+
+    if (!movie->current_frame_surface)
+    {
+        GleedSetError("No frame available, you must decode a frame first");
+        return false;
+    }
+
+    return GleedUpdateTextureFromSurface(movie->current_frame_surface, texture);
+}
+
+bool GleedUpdateTextureFromSurface(SDL_Surface *surface, SDL_Texture *texture)
+{
+    if (texture->format != surface->format)
+    {
+        GleedSetError("Texture format does not match video frame format, provided = %d, required = %d",
+                      texture->format, surface->format);
+        return false;
+    }
+
+    /* Formats match, so this is a single copy - no blitter involved. Sizes may not, the overlap is copied as a blit would */
+    const SDL_Rect rect = {0, 0, SDL_min(texture->w, surface->w), SDL_min(texture->h, surface->h)};
+
+    if (!SDL_UpdateTexture(texture, &rect, surface->pixels, surface->pitch))
+    {
+        return GleedSetError("Failed to update texture: %s", SDL_GetError());
+    }
+
+    return true;
+}
+
+void GleedReadCurrentFrame(GleedMovie *movie, GleedMovieTrackType type)
+{
+    if (!movie)
+        return;
+
+    int target_track_index = type == GLEED_TRACK_TYPE_VIDEO ? movie->current_video_track : movie->current_audio_track;
+
+    if (target_track_index == GLEED_NO_TRACK)
+    {
+        return;
+    }
+
+    if (type == GLEED_TRACK_TYPE_VIDEO)
+    {
+        CachedMovieFrame *frame = &movie->cached_frames[target_track_index][movie->current_frame];
+
+        if (!movie->encoded_video_frame || movie->encoded_video_frame_size < frame->size)
+        {
+            movie->encoded_video_frame = SDL_realloc(movie->encoded_video_frame, frame->size);
+        }
+
+        SDL_LockMutex(movie->io_lock);
+        SDL_SeekIO(movie->io, frame->offset, SDL_IO_SEEK_SET);
+        SDL_ReadIO(movie->io, movie->encoded_video_frame, frame->size);
+        SDL_UnlockMutex(movie->io_lock);
+
+        movie->encoded_video_frame_size = frame->size;
+    }
+    else
+    {
+        CachedMovieFrame *frame = &movie->cached_frames[target_track_index][movie->current_audio_frame];
 
         /* If we have preloaded all our encoded audio data into one big buffer, just point inside it*/
         if (movie->encoded_audio_buffer && movie->encoded_audio_buffer_size > 0)
@@ -422,9 +1106,10 @@ void GleedReadCurrentFrame(GleedMovie *movie, GleedMovieTrackType type)
                 movie->encoded_audio_frame = SDL_realloc(movie->encoded_audio_frame, frame->size);
             }
 
+            SDL_LockMutex(movie->io_lock);
             SDL_SeekIO(movie->io, frame->offset, SDL_IO_SEEK_SET);
-
             SDL_ReadIO(movie->io, movie->encoded_audio_frame, frame->size);
+            SDL_UnlockMutex(movie->io_lock);
         }
 
         movie->encoded_audio_frame_size = frame->size;
@@ -438,6 +1123,13 @@ Uint32 GleedGetLastFrameDecodeTime(GleedMovie *movie)
     return movie->last_frame_decode_ms;
 }
 
+Uint64 GleedGetLastFrameDecodeTimeNS(GleedMovie *movie)
+{
+    if (!movie)
+        return 0;
+    return movie->last_frame_decode_ns;
+}
+
 Uint32 GleedGetTotalVideoFrames(GleedMovie *movie)
 {
     if (!movie)
@@ -477,12 +1169,274 @@ void GleedGetVideoSize(GleedMovie *movie, int *w, int *h)
     if (movie->current_video_track == GLEED_NO_TRACK)
         return;
 
-    GleedMovieTrack *video_track = GleedGetVideoTrack(movie);
+    GleedGetVideoOutputSize(movie, w, h);
+}
+
+void GleedGetVideoOutputSize(GleedMovie *movie, int *w, int *h)
+{
+    const bool has_output_size = movie->video_output_w > 0 && movie->video_output_h > 0;
 
     if (w)
-        *w = video_track->video_width;
+        *w = has_output_size ? movie->video_output_w : movie->video_crop.w;
     if (h)
-        *h = video_track->video_height;
+        *h = has_output_size ? movie->video_output_h : movie->video_crop.h;
+}
+
+SDL_Surface *GleedCreateVideoFrameSurface(GleedMovie *movie, int w, int h)
+{
+    SDL_Surface *surface = SDL_CreateSurface(w, h, movie->video_pixel_format);
+
+    if (!surface)
+    {
+        GleedSetError("Failed to create video frame surface: %s", SDL_GetError());
+        return NULL;
+    }
+
+    /* Frames are handed out to the caller, blitting one should copy its pixels and alpha rather than composite it over the target */
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+
+    return surface;
+}
+
+SDL_Surface *GleedEnsureVideoFrameSurface(GleedMovie *movie)
+{
+    if (!movie->current_frame_surface)
+    {
+        int w, h;
+        GleedGetVideoOutputSize(movie, &w, &h);
+
+        movie->current_frame_surface = GleedCreateVideoFrameSurface(movie, w, h);
+    }
+
+    return movie->current_frame_surface;
+}
+
+static bool GleedRecreateVideoFrameSurface(GleedMovie *movie)
+{
+    int w, h;
+    GleedGetVideoOutputSize(movie, &w, &h);
+
+    SDL_Surface *surface = movie->current_frame_surface;
+
+    /* Nothing to recreate yet, the surface is allocated with the first frame converted into it */
+    if (!surface)
+    {
+        return true;
+    }
+
+    if (surface->w == w && surface->h == h && surface->format == movie->video_pixel_format)
+    {
+        return true;
+    }
+
+    SDL_DestroySurface(surface);
+
+    movie->current_frame_surface = GleedCreateVideoFrameSurface(movie, w, h);
+
+    return movie->current_frame_surface != NULL;
+}
+
+bool GleedSetVideoOutputFormat(GleedMovie *movie, SDL_PixelFormat format)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    if (format != SDL_PIXELFORMAT_UNKNOWN && !GleedIsVideoOutputFormatSupported(format))
+        return GleedSetError("Unsupported output pixel format: %s", SDL_GetPixelFormatName(format));
+
+    movie->video_output_format = format;
+
+    /* Without a video track, the format is applied when one gets selected */
+    if (movie->current_video_track == GLEED_NO_TRACK)
+        return true;
+
+    movie->video_pixel_format = GleedGetTrackVideoPixelFormat(movie, GleedGetVideoTrack(movie));
+
+    return GleedRecreateVideoFrameSurface(movie);
+}
+
+SDL_PixelFormat GleedGetVideoOutputFormat(GleedMovie *movie)
+{
+    if (!movie || movie->current_video_track == GLEED_NO_TRACK)
+        return SDL_PIXELFORMAT_UNKNOWN;
+
+    return movie->video_pixel_format;
+}
+
+bool GleedSetVideoMipmapsEnabled(GleedMovie *movie, bool enabled)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    movie->video_mipmaps = enabled;
+
+    /* Levels attached to the last frame would go stale */
+    if (!enabled && movie->current_frame_surface)
+        SDL_RemoveSurfaceAlternateImages(movie->current_frame_surface);
+
+    return true;
+}
+
+/* Replaces the transform of the movie, taking over the reference; conversions in flight keep the one they acquired */
+static void GleedSwapVideoColorTransform(GleedMovie *movie, GleedColorTransformTables *tables)
+{
+    SDL_LockSpinlock(&movie->video_color_lock);
+
+    GleedColorTransformTables *old = movie->video_color;
+    movie->video_color = tables;
+
+    SDL_UnlockSpinlock(&movie->video_color_lock);
+
+    GleedReleaseColorTransform(old);
+}
+
+GleedColorTransformTables *GleedAcquireVideoColorTransform(GleedMovie *movie)
+{
+    SDL_LockSpinlock(&movie->video_color_lock);
+
+    GleedColorTransformTables *tables = movie->video_color;
+
+    if (tables)
+        SDL_AtomicIncRef(&tables->refcount);
+
+    SDL_UnlockSpinlock(&movie->video_color_lock);
+
+    return tables;
+}
+
+void GleedShareVideoColorTransform(GleedMovie *movie, GleedMovie *source)
+{
+    if (movie != source)
+        GleedSwapVideoColorTransform(movie, GleedAcquireVideoColorTransform(source));
+}
+
+bool GleedSetVideoColorTransform(GleedMovie *movie, const GleedColorTransform *transform)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    GleedColorTransformTables *tables = NULL;
+
+    if (transform)
+    {
+        tables = GleedCompileColorTransform(transform);
+
+        if (!tables)
+            return false;
+    }
+
+    GleedSwapVideoColorTransform(movie, tables);
+
+    return true;
+}
+
+bool GleedSetVideoOutputSize(GleedMovie *movie, int w, int h)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    if (movie->current_video_track == GLEED_NO_TRACK)
+        return GleedSetError("No video track selected");
+
+    if (w < 0 || h < 0 || (w == 0) != (h == 0))
+        return GleedSetError("Invalid video output size %dx%d", w, h);
+
+    movie->video_output_w = w;
+    movie->video_output_h = h;
+
+    return GleedRecreateVideoFrameSurface(movie);
+}
+
+bool GleedSetVideoCrop(GleedMovie *movie, const SDL_Rect *crop)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    if (movie->current_video_track == GLEED_NO_TRACK)
+        return GleedSetError("No video track selected");
+
+    const GleedMovieTrack *video_track = GleedGetVideoTrack(movie);
+
+    const SDL_Rect frame_rect = {0, 0, (int)video_track->video_width, (int)video_track->video_height};
+
+    SDL_Rect new_crop = frame_rect;
+
+    if (crop)
+    {
+        if (!SDL_GetRectIntersection(crop, &frame_rect, &new_crop))
+            return GleedSetError("Crop rectangle is outside of the video frame");
+    }
+    else if (video_track->video_crop_left + video_track->video_crop_right < video_track->video_width &&
+             video_track->video_crop_top + video_track->video_crop_bottom < video_track->video_height)
+    {
+        new_crop.x = video_track->video_crop_left;
+        new_crop.y = video_track->video_crop_top;
+        new_crop.w = video_track->video_width - video_track->video_crop_left - video_track->video_crop_right;
+        new_crop.h = video_track->video_height - video_track->video_crop_top - video_track->video_crop_bottom;
+    }
+
+    movie->video_crop = new_crop;
+
+    return GleedRecreateVideoFrameSurface(movie);
+}
+
+bool GleedSetVideoDecodeQuality(GleedMovie *movie, GleedVideoDecodeQuality quality)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    if (quality < GLEED_VIDEO_QUALITY_FULL || quality > GLEED_VIDEO_QUALITY_FASTEST)
+        return GleedSetError("Invalid video decode quality %d", (int)quality);
+
+    /* Cached groups of pictures were decoded with the old quality */
+    if (SDL_SetAtomicInt(&movie->video_quality, (int)quality) != (int)quality)
+        GleedDestroyGOPCache(movie);
+
+    return true;
+}
+
+GleedVideoDecodeQuality GleedGetVideoDecodeQuality(GleedMovie *movie)
+{
+    return (GleedVideoDecodeQuality)SDL_GetAtomicInt(&movie->video_quality);
+}
+
+bool GleedGetVideoDecodeTimeDelta(const GleedMovieVideoStats *stats, GleedVideoDecodeQuality quality, Sint64 *delta_ns)
+{
+    if (!stats || !delta_ns)
+        return GleedSetError("stats and delta_ns cannot be NULL");
+
+    if (quality < GLEED_VIDEO_QUALITY_FULL || quality > GLEED_VIDEO_QUALITY_FASTEST)
+        return GleedSetError("Invalid video decode quality %d", (int)quality);
+
+    if (stats->quality_decoded_frames[GLEED_VIDEO_QUALITY_FULL] == 0 || stats->quality_decoded_frames[quality] == 0)
+        return GleedSetError("No frames decoded with both qualities yet");
+
+    const Uint64 full_ns = stats->quality_decode_ns[GLEED_VIDEO_QUALITY_FULL] / stats->quality_decoded_frames[GLEED_VIDEO_QUALITY_FULL];
+    const Uint64 quality_ns = stats->quality_decode_ns[quality] / stats->quality_decoded_frames[quality];
+
+    *delta_ns = (Sint64)quality_ns - (Sint64)full_ns;
+
+    return true;
+}
+
+bool GleedSetVideoFrameCacheEnabled(GleedMovie *movie, bool enabled)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    movie->video_cache_enabled = enabled;
+
+    return true;
+}
+
+bool GleedSetVideoPremultipliedAlpha(GleedMovie *movie, bool premultiplied)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    movie->video_premultiplied_alpha = premultiplied;
+
+    return true;
 }
 
 const SDL_Surface *GleedGetVideoFrameSurface(GleedMovie *movie)
@@ -495,15 +1449,143 @@ const SDL_Surface *GleedGetVideoFrameSurface(GleedMovie *movie)
     return movie->current_frame_surface;
 }
 
-void GleedSeekFrame(GleedMovie *movie, Uint32 frame)
+const GleedVideoFrameYUV *GleedAcquireVideoFrameYUV(GleedMovie *movie)
 {
     if (!movie)
+    {
+        GleedSetError("Invalid movie");
+        return NULL;
+    }
+
+    if (movie->video_cache_hit)
+    {
+        GleedSetError("Frame was taken from the frame cache, it has no YUV planes");
+        return NULL;
+    }
+
+    if (movie->video_codec == GLEED_CODEC_TYPE_VP8 || movie->video_codec == GLEED_CODEC_TYPE_VP9)
+    {
+        return GleedAcquireVPXFrame(movie);
+    }
+
+    GleedSetError("No decoded video frame available");
+
+    return NULL;
+}
+
+void GleedReleaseVideoFrameYUV(const GleedVideoFrameYUV *frame)
+{
+    if (!frame)
         return;
 
+    GleedVideoFrameRef *ref = (GleedVideoFrameRef *)frame;
+
+    GleedReleaseFrameBuffer(ref->buffer);
+    GleedReleaseFrameBufferPool(ref->pool);
+
+    SDL_free(ref);
+}
+
+static bool GleedReadPacket(GleedMovie *movie, Uint32 offset, Uint32 size, Uint32 frame, Uint8 **data, Uint32 *capacity)
+{
+    if (*capacity < size)
+    {
+        Uint8 *new_data = (Uint8 *)SDL_realloc(*data, size);
+
+        if (!new_data)
+            return GleedSetError("Failed to allocate %u bytes for frame %u", size, frame);
+
+        *data = new_data;
+        *capacity = size;
+    }
+
+    SDL_LockMutex(movie->io_lock);
+    SDL_SeekIO(movie->io, offset, SDL_IO_SEEK_SET);
+    const size_t read = SDL_ReadIO(movie->io, *data, size);
+    SDL_UnlockMutex(movie->io_lock);
+
+    if (read != size)
+        return GleedSetError("Failed to read frame %u: %s", frame, SDL_GetError());
+
+    return true;
+}
+
+bool GleedReadVideoPacket(GleedMovie *movie, Uint32 frame, Uint8 **data, Uint32 *capacity)
+{
+    const CachedMovieFrame *cached_frame = &movie->cached_frames[movie->current_video_track][frame];
+
+    return GleedReadPacket(movie, cached_frame->offset, cached_frame->size, frame, data, capacity);
+}
+
+bool GleedReadVideoAlphaPacket(GleedMovie *movie, Uint32 frame, Uint8 **data, Uint32 *capacity)
+{
+    const CachedMovieFrame *cached_frame = &movie->cached_frames[movie->current_video_track][frame];
+
+    return GleedReadPacket(movie, cached_frame->alpha_offset, cached_frame->alpha_size, frame, data, capacity);
+}
+
+Uint32 GleedFindVideoKeyFrame(GleedMovie *movie, Uint32 frame)
+{
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    while (frame > 0 && !frames[frame].key_frame)
+    {
+        frame--;
+    }
+
+    /* First frame is always decodable from scratch, even if it was not flagged */
+    return frame;
+}
+
+void GleedResetAudioDecoder(GleedMovie *movie)
+{
+    if (movie->audio_codec == GLEED_CODEC_TYPE_VORBIS)
+    {
+        GleedResetVorbis(movie);
+    }
+    else if (movie->audio_codec == GLEED_CODEC_TYPE_OPUS)
+    {
+        GleedResetOpus(movie);
+    }
+}
+
+int GleedSeekFrame(GleedMovie *movie, Uint32 frame)
+{
+    if (!movie)
+    {
+        GleedSetError("Invalid movie");
+        return -1;
+    }
+
+    if (!GleedCanPlaybackVideo(movie))
+    {
+        GleedSetError("No tracks or playback data available");
+        return -1;
+    }
+
     if (frame >= movie->total_frames)
-        return;
+    {
+        GleedSetError("Frame %u is out of range, movie has %u frames", frame, movie->total_frames);
+        return -1;
+    }
+
+    const Uint32 decoded_frames_before = movie->video_stats.decoded_frames;
+
+    if (!GleedCatchUpVideoDecoder(movie, frame))
+    {
+        return -1;
+    }
+
+    if (GleedCanPlaybackAudio(movie))
+    {
+        const Uint64 timecode = movie->cached_frames[movie->current_video_track][frame].timecode;
+
+        movie->current_audio_frame = GleedFindFrameAtTimecode(movie, movie->current_audio_track, timecode);
+
+        GleedResetAudioDecoder(movie);
+    }
 
-    movie->current_frame = frame;
+    return (int)(movie->video_stats.decoded_frames - decoded_frames_before);
 }
 
 bool GleedHasNextAudioFrame(GleedMovie *movie)
@@ -611,6 +1693,8 @@ bool GleedPreloadAudioStream(GleedMovie *movie)
 
     Uint32 offset = 0;
 
+    SDL_LockMutex(movie->io_lock);
+
     for (Uint32 frame = 0; frame < audio_track->total_frames; frame++)
     {
         CachedMovieFrame *frame_data = &movie->cached_frames[movie->current_audio_track][frame];
@@ -624,6 +1708,8 @@ bool GleedPreloadAudioStream(GleedMovie *movie)
         SDL_assert(offset <= buffer_size);
     }
 
+    SDL_UnlockMutex(movie->io_lock);
+
     return true;
 }
 
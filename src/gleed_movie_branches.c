@@ -0,0 +1,184 @@
+#include "gleed_movie_internal.h"
+
+struct GleedPlayerBranches
+{
+    GleedMoviePlayer *players[GLEED_MAX_PLAYER_BRANCHES]; /**< Prepared players, NULL once committed */
+    int count;                                            /**< Number of branches added */
+    size_t memory_budget;                                 /**< Bytes of converted frames all branches may hold together */
+    size_t memory_used;                                   /**< Bytes of converted frames held by the branches added so far */
+    SDL_AudioDeviceID audio_device;                       /**< Device the branches play to, 0 for no audio output */
+};
+
+/* Frames up to the second keyframe, the part of the movie that has to be decoded before anything can be skipped */
+static Uint32 GleedGetFirstGOPLength(GleedMovie *mov)
+{
+    const CachedMovieFrame *frames = mov->cached_frames[mov->current_video_track];
+
+    Uint32 length = 1;
+
+    while (length < mov->total_frames && !frames[length].key_frame)
+    {
+        length++;
+    }
+
+    return length;
+}
+
+static size_t GleedGetVideoFrameBytes(GleedMovie *mov)
+{
+    int w, h;
+    GleedGetVideoOutputSize(mov, &w, &h);
+
+    const size_t bytes = (size_t)w * h * SDL_BYTESPERPIXEL(mov->video_pixel_format);
+
+    /* Mip chain adds a third of the full size image */
+    return mov->video_mipmaps ? bytes + bytes / 3 : bytes;
+}
+
+static int GleedAddPreparedBranch(GleedPlayerBranches *branches, GleedMoviePlayer *player)
+{
+    GleedMovie *mov = player->mov;
+
+    /* Paused player has its audio stream unbound, so the samples queued by the preparation wait for the commit */
+    if (branches->audio_device && GleedCanPlaybackAudio(mov) && !GleedSetPlayerAudioOutput(player, branches->audio_device))
+    {
+        GleedFreePlayer(player);
+        return -1;
+    }
+
+    GleedPausePlayer(player);
+
+    size_t frames_bytes = 0;
+
+    if (GleedCanPlaybackVideo(mov))
+    {
+        const size_t frame_bytes = SDL_max(GleedGetVideoFrameBytes(mov), 1);
+        const size_t room = branches->memory_budget > branches->memory_used ? branches->memory_budget - branches->memory_used : 0;
+
+        /* Queue is filled by the decoder thread while the choice is pending; without room, only the first frame is prepared */
+        const Uint32 frames = (Uint32)SDL_min((size_t)GleedGetFirstGOPLength(mov), room / frame_bytes);
+
+        if (frames > 0 && !GleedSetPlayerDecodeAhead(player, (int)frames))
+        {
+            GleedFreePlayer(player);
+            return -1;
+        }
+
+        frames_bytes = SDL_max(frames, 1) * frame_bytes;
+    }
+
+    if (!GleedPreparePlayer(player))
+    {
+        GleedFreePlayer(player);
+        return -1;
+    }
+
+    branches->memory_used += frames_bytes;
+    branches->players[branches->count] = player;
+
+    return branches->count++;
+}
+
+GleedPlayerBranches *GleedCreatePlayerBranches(size_t memory_budget, SDL_AudioDeviceID audio_device)
+{
+    if (audio_device == SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK)
+    {
+        GleedSetError("Audio output device must be already opened or 0 to disable");
+        return NULL;
+    }
+
+    GleedPlayerBranches *branches = (GleedPlayerBranches *)SDL_calloc(1, sizeof(GleedPlayerBranches));
+
+    if (!branches)
+    {
+        GleedSetError("Failed to allocate memory for player branches");
+        return NULL;
+    }
+
+    branches->memory_budget = memory_budget;
+    branches->audio_device = audio_device;
+
+    return branches;
+}
+
+int GleedAddPlayerBranch(GleedPlayerBranches *branches, const char *path)
+{
+    if (!branches || !path)
+    {
+        GleedSetError("Invalid arguments");
+        return -1;
+    }
+
+    if (branches->count >= GLEED_MAX_PLAYER_BRANCHES)
+    {
+        GleedSetError("Too many player branches, at most %d are supported", GLEED_MAX_PLAYER_BRANCHES);
+        return -1;
+    }
+
+    GleedMoviePlayer *player = GleedCreatePlayerFromPath(path);
+
+    if (!player)
+    {
+        return -1;
+    }
+
+    return GleedAddPreparedBranch(branches, player);
+}
+
+int GleedAddPlayerBranchFromIO(GleedPlayerBranches *branches, SDL_IOStream *io)
+{
+    if (!branches || !io)
+    {
+        GleedSetError("Invalid arguments");
+        return -1;
+    }
+
+    if (branches->count >= GLEED_MAX_PLAYER_BRANCHES)
+    {
+        GleedSetError("Too many player branches, at most %d are supported", GLEED_MAX_PLAYER_BRANCHES);
+        return -1;
+    }
+
+    GleedMoviePlayer *player = GleedCreatePlayerFromIO(io);
+
+    if (!player)
+    {
+        return -1;
+    }
+
+    return GleedAddPreparedBranch(branches, player);
+}
+
+GleedMoviePlayer *GleedCommitPlayerBranch(GleedPlayerBranches *branches, int index)
+{
+    if (!branches)
+    {
+        GleedSetError("Invalid player branches");
+        return NULL;
+    }
+
+    if (index < 0 || index >= branches->count || !branches->players[index])
+    {
+        GleedSetError("Branch %d does not exist or was committed already", index);
+        return NULL;
+    }
+
+    /* Other branches are left as they are, tearing down their decoder threads would stall the transition */
+    GleedMoviePlayer *player = branches->players[index];
+    branches->players[index] = NULL;
+
+    return player;
+}
+
+void GleedFreePlayerBranches(GleedPlayerBranches *branches)
+{
+    if (!branches)
+        return;
+
+    for (int i = 0; i < branches->count; i++)
+    {
+        GleedFreePlayer(branches->players[i]);
+    }
+
+    SDL_free(branches);
+}
@@ -0,0 +1,1156 @@
+#include "gleed_movie_internal.h"
+
+/*
+    YUV to RGB conversion straight from the decoder planes.
+
+    Each output row goes through three stages, working on chunks small enough to live on the stack:
+    1) unpack - source samples are fetched (chroma upsampled) into 16-bit rows of a common 14-bit scale,
+    2) matrix - fixed-point YUV to RGB, with an SSE2 kernel when available,
+    3) pack - planar R, G and B rows are interleaved into the output pixel layout.
+
+    When the crop rectangle and the output differ in size, unpack resamples instead: every plane is first filtered
+    vertically into a full-width row, then horizontally into the chunk. Each axis uses bilinear filtering,
+    or a box filter when downscaling by 2 or more, where bilinear would skip source pixels and alias.
+
+    High bit depth sources (10 and 12-bit, stored in 16-bit words) take the same path. The precision they have
+    above 8 bits survives into the kernel's fractional bits, which get an ordered dither instead of plain rounding,
+    so gradients don't band and no extra pass over the frame is needed.
+
+    Alpha comes from the luma plane of a separately decoded frame (WebM stores it as a second stream).
+    It is unpacked and resampled along with the colour planes and merged in the pack stage, premultiplied there if asked.
+
+    Fast conversion trades quality for speed: scaling picks the nearest source sample instead of filtering,
+    and deep sources are rounded instead of dithered.
+
+    A colour transform, when set, runs between the matrix and pack stages on the planar chunk rows: an affine colour
+    matrix through per-channel contribution tables, then one lookup per channel with gamma and fade folded together.
+
+    Mip levels, when asked for, are attached to the output surface as alternate images and filled in the same pass:
+    every second finished row of a level is box filtered with the one before into the next level, recursively,
+    so each row is read back while it is still in cache rather than in another pass over the frame.
+*/
+
+#define GLEED_CONVERT_CHUNK 256
+
+/* 8 to 12-bit sources share one kernel, and products still fit signed 16-bit SIMD lanes */
+#define GLEED_SAMPLE_BITS 14
+
+#define GLEED_CHROMA_OFFSET (1 << (GLEED_SAMPLE_BITS - 1))
+
+/* Matrix coefficients are Q13, so the kernel output has 3 fractional bits above 8-bit RGB */
+#define GLEED_MATRIX_BITS 13
+#define GLEED_KERNEL_FRACTION_BITS (GLEED_SAMPLE_BITS + GLEED_MATRIX_BITS - 16 - 8)
+
+typedef struct
+{
+    Sint16 y_offset; /**< Luma black level, in sample scale */
+    Sint16 y_scale;  /**< Luma range expansion */
+    Sint16 r_v;      /**< V contribution to red */
+    Sint16 g_u;      /**< U contribution to green (subtracted) */
+    Sint16 g_v;      /**< V contribution to green (subtracted) */
+    Sint16 b_u;      /**< U contribution to blue */
+} GleedYUVMatrix;
+
+typedef struct
+{
+    int bytes_per_pixel;
+    int r;
+    int g;
+    int b;
+    int a; /**< Offset of alpha, -1 if the format has none */
+    int x; /**< Offset of the unused byte of 32-bit formats without alpha, -1 if the format has none */
+} GleedPixelLayout;
+
+/* Source footprint of one output sample along one axis, in plane coordinates */
+typedef struct
+{
+    int first;  /**< First source sample */
+    int last;   /**< Bilinear: second source sample, box: one past the last source sample */
+    int weight; /**< Bilinear: Q6 weight of the second sample, unused for box */
+} GleedScaleTap;
+
+/*
+    Kernel adds rounding[i & 7] to pixel i before dropping the fractional bits,
+    so chunks must start at a multiple of 8 pixels for the dither pattern to line up
+*/
+typedef void (*GleedYUVToRGBKernel)(const GleedYUVMatrix *matrix, const Sint16 *y, const Sint16 *u, const Sint16 *v, const Sint16 *rounding, Uint8 *r, Uint8 *g, Uint8 *b, int count);
+
+/*
+    4x4 Bayer matrix halved to the kernel's 3 fractional bits. Every offset 0..7 appears twice,
+    so a value with fraction f/8 rounds up at exactly f of 8 offsets - the average stays unbiased.
+*/
+static const Sint16 gleed_dither_4x4[4][4] = {
+    {0, 4, 1, 5},
+    {6, 2, 7, 3},
+    {1, 5, 0, 4},
+    {7, 3, 6, 2},
+};
+
+static void GleedGetYUVMatrix(SDL_Colorspace colorspace, GleedYUVMatrix *matrix)
+{
+    float kr = 0.299f;
+    float kb = 0.114f;
+    bool full_range = false;
+
+    switch (colorspace)
+    {
+    case SDL_COLORSPACE_BT601_FULL:
+        full_range = true;
+        break;
+    case SDL_COLORSPACE_BT709_FULL:
+        full_range = true;
+        /* fallthrough */
+    case SDL_COLORSPACE_BT709_LIMITED:
+        kr = 0.2126f;
+        kb = 0.0722f;
+        break;
+    case SDL_COLORSPACE_BT2020_FULL:
+        full_range = true;
+        /* fallthrough */
+    case SDL_COLORSPACE_BT2020_LIMITED:
+        kr = 0.2627f;
+        kb = 0.0593f;
+        break;
+    default:
+        /* BT.601 limited range, same as SDL_COLORSPACE_YUV_DEFAULT */
+        break;
+    }
+
+    const float kg = 1.0f - kr - kb;
+    const float y_range = full_range ? 1.0f : 255.0f / 219.0f;
+    const float c_range = full_range ? 1.0f : 255.0f / 224.0f;
+    const float one = (float)(1 << GLEED_MATRIX_BITS);
+
+    matrix->y_offset = full_range ? 0 : 16 << (GLEED_SAMPLE_BITS - 8);
+    matrix->y_scale = (Sint16)(y_range * one + 0.5f);
+    matrix->r_v = (Sint16)(2.0f * (1.0f - kr) * c_range * one + 0.5f);
+    matrix->g_u = (Sint16)(2.0f * kb * (1.0f - kb) / kg * c_range * one + 0.5f);
+    matrix->g_v = (Sint16)(2.0f * kr * (1.0f - kr) / kg * c_range * one + 0.5f);
+    matrix->b_u = (Sint16)(2.0f * (1.0f - kb) * c_range * one + 0.5f);
+}
+
+static bool GleedGetPixelLayout(SDL_PixelFormat format, GleedPixelLayout *layout)
+{
+    switch (format)
+    {
+    case SDL_PIXELFORMAT_RGB24:
+        *layout = (GleedPixelLayout){3, 0, 1, 2, -1, -1};
+        return true;
+    case SDL_PIXELFORMAT_BGR24:
+        *layout = (GleedPixelLayout){3, 2, 1, 0, -1, -1};
+        return true;
+    /* 32-bit formats are matched by their byte order aliases, so packed ones like XRGB8888 map to the right bytes on any endianness */
+    case SDL_PIXELFORMAT_RGBA32:
+        *layout = (GleedPixelLayout){4, 0, 1, 2, 3, -1};
+        return true;
+    case SDL_PIXELFORMAT_BGRA32:
+        *layout = (GleedPixelLayout){4, 2, 1, 0, 3, -1};
+        return true;
+    case SDL_PIXELFORMAT_ARGB32:
+        *layout = (GleedPixelLayout){4, 1, 2, 3, 0, -1};
+        return true;
+    case SDL_PIXELFORMAT_ABGR32:
+        *layout = (GleedPixelLayout){4, 3, 2, 1, 0, -1};
+        return true;
+    case SDL_PIXELFORMAT_RGBX32:
+        *layout = (GleedPixelLayout){4, 0, 1, 2, -1, 3};
+        return true;
+    case SDL_PIXELFORMAT_BGRX32:
+        *layout = (GleedPixelLayout){4, 2, 1, 0, -1, 3};
+        return true;
+    case SDL_PIXELFORMAT_XRGB32:
+        *layout = (GleedPixelLayout){4, 1, 2, 3, -1, 0};
+        return true;
+    case SDL_PIXELFORMAT_XBGR32:
+        *layout = (GleedPixelLayout){4, 3, 2, 1, -1, 0};
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void GleedUnpackYUVRow(const GleedVideoFrameYUV *src, int row, int x, int count, Sint16 *y, Sint16 *u, Sint16 *v)
+{
+    const int shift = GLEED_SAMPLE_BITS - src->bit_depth;
+    const int chroma_row = row >> src->chroma_shift_y;
+
+    const Uint8 *y_row = src->planes[0] + row * src->pitches[0];
+    const Uint8 *u_row = src->planes[1] + chroma_row * src->pitches[1];
+    const Uint8 *v_row = src->planes[2] + chroma_row * src->pitches[2];
+
+    if (src->bit_depth > 8)
+    {
+        const Uint16 *y_row16 = (const Uint16 *)y_row;
+        const Uint16 *u_row16 = (const Uint16 *)u_row;
+        const Uint16 *v_row16 = (const Uint16 *)v_row;
+
+        for (int i = 0; i < count; i++)
+        {
+            const int chroma_x = (x + i) >> src->chroma_shift_x;
+
+            y[i] = (Sint16)(y_row16[x + i] << shift);
+            u[i] = (Sint16)(u_row16[chroma_x] << shift);
+            v[i] = (Sint16)(v_row16[chroma_x] << shift);
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const int chroma_x = (x + i) >> src->chroma_shift_x;
+
+        y[i] = (Sint16)(y_row[x + i] << shift);
+        u[i] = (Sint16)(u_row[chroma_x] << shift);
+        v[i] = (Sint16)(v_row[chroma_x] << shift);
+    }
+}
+
+/* Alpha samples are stored as-is in the luma plane of the alpha frame, no range or matrix applies */
+static void GleedUnpackAlphaRow(const GleedVideoFrameYUV *alpha, int row, int x, int count, Uint8 *a)
+{
+    const Uint8 *a_row = alpha->planes[0] + row * alpha->pitches[0];
+
+    if (alpha->bit_depth > 8)
+    {
+        const Uint16 *a_row16 = (const Uint16 *)a_row;
+        const int shift = alpha->bit_depth - 8;
+
+        for (int i = 0; i < count; i++)
+        {
+            const int value = (a_row16[x + i] + (1 << (shift - 1))) >> shift;
+            a[i] = (Uint8)SDL_min(value, 255);
+        }
+
+        return;
+    }
+
+    SDL_memcpy(a, a_row + x, count);
+}
+
+/* Resampled alpha comes out on the 14-bit sample scale */
+static void GleedSamplesToAlpha(const Sint16 *samples, Uint8 *a, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const int value = (samples[i] + (1 << (GLEED_SAMPLE_BITS - 9))) >> (GLEED_SAMPLE_BITS - 8);
+        a[i] = (Uint8)SDL_clamp(value, 0, 255);
+    }
+}
+
+/*
+    Footprint of output sample i, when crop_count source (luma) samples starting at crop_start are scaled to dst_count.
+    Chroma planes pass their subsampling shift, sample centres stay aligned with luma.
+*/
+static void GleedGetScaleTap(int crop_start, int crop_count, int dst_count, int shift, bool box, int i, GleedScaleTap *tap)
+{
+    const Sint64 step = ((Sint64)crop_count << 16) / dst_count;
+    const Sint64 origin = (Sint64)crop_start << 16;
+    const int plane_start = crop_start >> shift;
+    const int plane_end = (crop_start + crop_count + (1 << shift) - 1) >> shift;
+
+    if (box)
+    {
+        const int first = (int)((origin + i * step) >> (16 + shift));
+        const int last = (int)((origin + (i + 1) * step) >> (16 + shift));
+
+        tap->first = SDL_clamp(first, plane_start, plane_end - 1);
+        tap->last = SDL_clamp(last, tap->first + 1, plane_end);
+        tap->weight = 0;
+    }
+    else
+    {
+        Sint64 position = ((origin + (2 * i + 1) * step / 2) >> shift) - (1 << 15);
+        position = SDL_clamp(position, (Sint64)plane_start << 16, (Sint64)(plane_end - 1) << 16);
+
+        tap->first = (int)(position >> 16);
+        tap->last = SDL_min(tap->first + 1, plane_end - 1);
+        tap->weight = (int)((position >> 10) & 63);
+    }
+}
+
+/* Turns a bilinear tap into nearest sample, for fast conversion */
+static void GleedSnapScaleTap(GleedScaleTap *tap)
+{
+    if (tap->weight >= 32)
+    {
+        tap->first = tap->last;
+    }
+
+    tap->last = tap->first;
+    tap->weight = 0;
+}
+
+static void GleedResampleColumnsScalar(const Uint8 *r0, const Uint8 *r1, int weight, Sint16 *dst, int count)
+{
+    const int w0 = 64 - weight;
+
+    for (int x = 0; x < count; x++)
+    {
+        dst[x] = (Sint16)(r0[x] * w0 + r1[x] * weight);
+    }
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") GleedResampleColumnsSSE2(const Uint8 *r0, const Uint8 *r1, int weight, Sint16 *dst, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w0 = _mm_set1_epi16((Sint16)(64 - weight));
+    const __m128i w1 = _mm_set1_epi16((Sint16)weight);
+
+    int x = 0;
+
+    for (; x + 16 <= count; x += 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(r0 + x));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(r1 + x));
+
+        /* 8-bit times Q6 weight lands exactly on the 14-bit sample scale */
+        const __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1));
+        const __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1));
+
+        _mm_storeu_si128((__m128i *)(dst + x), lo);
+        _mm_storeu_si128((__m128i *)(dst + x + 8), hi);
+    }
+
+    GleedResampleColumnsScalar(r0 + x, r1 + x, weight, dst + x, count - x);
+}
+#endif
+
+/* 16-bit flavour: Q6 blend of bit_depth samples is shifted down to the 14-bit scale */
+static void GleedResampleColumns16Scalar(const Uint16 *r0, const Uint16 *r1, int weight, int bit_depth, Sint16 *dst, int count)
+{
+    const int w0 = 64 - weight;
+    const int shift = bit_depth - 8;
+    const int rounding = 1 << (shift - 1);
+
+    for (int x = 0; x < count; x++)
+    {
+        dst[x] = (Sint16)((r0[x] * w0 + r1[x] * weight + rounding) >> shift);
+    }
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") GleedResampleColumns16SSE2(const Uint16 *r0, const Uint16 *r1, int weight, int bit_depth, Sint16 *dst, int count)
+{
+    /* Samples are at most 12-bit, so signed multiply-add of interleaved pairs is safe */
+    const __m128i weights = _mm_set1_epi32(((Uint32)weight << 16) | (Uint32)(64 - weight));
+    const __m128i rounding = _mm_set1_epi32(1 << (bit_depth - 9));
+    const __m128i shift = _mm_cvtsi32_si128(bit_depth - 8);
+
+    int x = 0;
+
+    for (; x + 8 <= count; x += 8)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(r0 + x));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(r1 + x));
+
+        const __m128i lo = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights), rounding), shift);
+        const __m128i hi = _mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights), rounding), shift);
+
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packs_epi32(lo, hi));
+    }
+
+    GleedResampleColumns16Scalar(r0 + x, r1 + x, weight, bit_depth, dst + x, count - x);
+}
+#endif
+
+/* Vertical pass: plane columns [x, x + count) of the rows under the tap, into 14-bit samples */
+static void GleedResamplePlaneRow(const Uint8 *plane, int pitch, int bit_depth, const GleedScaleTap *tap, bool box, int x, int count, Sint16 *dst)
+{
+    const bool high_bit_depth = bit_depth > 8;
+
+    if (box)
+    {
+        const int rows = tap->last - tap->first;
+        const int scale = (1 << (GLEED_SAMPLE_BITS - bit_depth + 16)) / rows;
+
+        for (int i = 0; i < count; i++)
+        {
+            const Uint8 *row = plane + tap->first * pitch;
+
+            int sum = 0;
+
+            for (int n = 0; n < rows; n++, row += pitch)
+            {
+                sum += high_bit_depth ? ((const Uint16 *)row)[x + i] : row[x + i];
+            }
+
+            dst[i] = (Sint16)((sum * scale) >> 16);
+        }
+
+        return;
+    }
+
+    const Uint8 *r0 = plane + tap->first * pitch;
+    const Uint8 *r1 = plane + tap->last * pitch;
+
+    /* Single source row (nearest sample or an exact hit), only the scale changes */
+    if (tap->weight == 0)
+    {
+        const int shift = GLEED_SAMPLE_BITS - bit_depth;
+
+        for (int i = 0; i < count; i++)
+        {
+            dst[i] = (Sint16)((high_bit_depth ? ((const Uint16 *)r0)[x + i] : r0[x + i]) << shift);
+        }
+
+        return;
+    }
+
+    if (high_bit_depth)
+    {
+#ifdef SDL_SSE2_INTRINSICS
+        if (SDL_HasSSE2())
+        {
+            GleedResampleColumns16SSE2((const Uint16 *)r0 + x, (const Uint16 *)r1 + x, tap->weight, bit_depth, dst, count);
+            return;
+        }
+#endif
+
+        GleedResampleColumns16Scalar((const Uint16 *)r0 + x, (const Uint16 *)r1 + x, tap->weight, bit_depth, dst, count);
+        return;
+    }
+
+#ifdef SDL_SSE2_INTRINSICS
+    if (SDL_HasSSE2())
+    {
+        GleedResampleColumnsSSE2(r0 + x, r1 + x, tap->weight, dst, count);
+        return;
+    }
+#endif
+
+    GleedResampleColumnsScalar(r0 + x, r1 + x, tap->weight, dst, count);
+}
+
+/* Horizontal pass: row holds 14-bit samples of the plane starting at row_start */
+static void GleedResampleRow(const Sint16 *row, int row_start, const GleedScaleTap *taps, bool box, Sint16 *dst, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const GleedScaleTap *tap = &taps[i];
+
+        if (box)
+        {
+            const int n = tap->last - tap->first;
+
+            int sum = 0;
+
+            for (int x = tap->first; x < tap->last; x++)
+            {
+                sum += row[x - row_start];
+            }
+
+            dst[i] = (Sint16)((sum + n / 2) / n);
+        }
+        else
+        {
+            const int a = row[tap->first - row_start];
+            const int b = row[tap->last - row_start];
+
+            dst[i] = (Sint16)((a * (64 - tap->weight) + b * tap->weight + 32) >> 6);
+        }
+    }
+}
+
+static Uint8 GleedKernelToByte(int value, int rounding)
+{
+    value = (value + rounding) >> GLEED_KERNEL_FRACTION_BITS;
+    return (Uint8)SDL_clamp(value, 0, 255);
+}
+
+/* Mirrors _mm_mulhi_epi16, so both kernels produce identical output */
+static int GleedMulHi(int a, int b)
+{
+    return (a * b) >> 16;
+}
+
+static void GleedYUVToRGBRowScalar(const GleedYUVMatrix *matrix, const Sint16 *y, const Sint16 *u, const Sint16 *v, const Sint16 *rounding, Uint8 *r, Uint8 *g, Uint8 *b, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const int luma = GleedMulHi(y[i] - matrix->y_offset, matrix->y_scale);
+        const int cb = u[i] - GLEED_CHROMA_OFFSET;
+        const int cr = v[i] - GLEED_CHROMA_OFFSET;
+        const int bias = rounding[i & 7];
+
+        r[i] = GleedKernelToByte(luma + GleedMulHi(cr, matrix->r_v), bias);
+        g[i] = GleedKernelToByte(luma - GleedMulHi(cb, matrix->g_u) - GleedMulHi(cr, matrix->g_v), bias);
+        b[i] = GleedKernelToByte(luma + GleedMulHi(cb, matrix->b_u), bias);
+    }
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") GleedYUVToRGBRowSSE2(const GleedYUVMatrix *matrix, const Sint16 *y, const Sint16 *u, const Sint16 *v, const Sint16 *rounding, Uint8 *r, Uint8 *g, Uint8 *b, int count)
+{
+    const __m128i y_offset = _mm_set1_epi16(matrix->y_offset);
+    const __m128i y_scale = _mm_set1_epi16(matrix->y_scale);
+    const __m128i r_v = _mm_set1_epi16(matrix->r_v);
+    const __m128i g_u = _mm_set1_epi16(matrix->g_u);
+    const __m128i g_v = _mm_set1_epi16(matrix->g_v);
+    const __m128i b_u = _mm_set1_epi16(matrix->b_u);
+    const __m128i chroma_offset = _mm_set1_epi16(GLEED_CHROMA_OFFSET);
+    const __m128i bias = _mm_loadu_si128((const __m128i *)rounding);
+
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i luma = _mm_mulhi_epi16(_mm_sub_epi16(_mm_loadu_si128((const __m128i *)(y + i)), y_offset), y_scale);
+        const __m128i cb = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(u + i)), chroma_offset);
+        const __m128i cr = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(v + i)), chroma_offset);
+
+        __m128i red = _mm_add_epi16(luma, _mm_mulhi_epi16(cr, r_v));
+        __m128i green = _mm_sub_epi16(_mm_sub_epi16(luma, _mm_mulhi_epi16(cb, g_u)), _mm_mulhi_epi16(cr, g_v));
+        __m128i blue = _mm_add_epi16(luma, _mm_mulhi_epi16(cb, b_u));
+
+        red = _mm_srai_epi16(_mm_add_epi16(red, bias), GLEED_KERNEL_FRACTION_BITS);
+        green = _mm_srai_epi16(_mm_add_epi16(green, bias), GLEED_KERNEL_FRACTION_BITS);
+        blue = _mm_srai_epi16(_mm_add_epi16(blue, bias), GLEED_KERNEL_FRACTION_BITS);
+
+        /* Saturating pack clamps to 0..255 for us */
+        _mm_storel_epi64((__m128i *)(r + i), _mm_packus_epi16(red, red));
+        _mm_storel_epi64((__m128i *)(g + i), _mm_packus_epi16(green, green));
+        _mm_storel_epi64((__m128i *)(b + i), _mm_packus_epi16(blue, blue));
+    }
+
+    GleedYUVToRGBRowScalar(matrix, y + i, u + i, v + i, rounding, r + i, g + i, b + i, count - i);
+}
+#endif
+
+static GleedYUVToRGBKernel GleedGetYUVToRGBKernel(void)
+{
+#ifdef SDL_SSE2_INTRINSICS
+    if (SDL_HasSSE2())
+    {
+        return GleedYUVToRGBRowSSE2;
+    }
+#endif
+
+    return GleedYUVToRGBRowScalar;
+}
+
+/* 8-bit sources round to nearest, deeper ones dither by output position unless converting fast */
+static void GleedGetRowRounding(int bit_depth, bool fast, int row, Sint16 *rounding)
+{
+    const bool dither = bit_depth > 8 && !fast;
+
+    for (int i = 0; i < 8; i++)
+    {
+        rounding[i] = dither ? gleed_dither_4x4[row & 3][i & 3] : 1 << (GLEED_KERNEL_FRACTION_BITS - 1);
+    }
+}
+
+static void GleedApplyColorTransform(const GleedColorTransformTables *color, Uint8 *r, Uint8 *g, Uint8 *b, int count)
+{
+    if (color->has_matrix)
+    {
+        const Sint32(*m)[3][256] = color->matrix;
+
+        for (int i = 0; i < count; i++)
+        {
+            const int red = (m[0][0][r[i]] + m[0][1][g[i]] + m[0][2][b[i]] + color->offset[0]) >> 8;
+            const int green = (m[1][0][r[i]] + m[1][1][g[i]] + m[1][2][b[i]] + color->offset[1]) >> 8;
+            const int blue = (m[2][0][r[i]] + m[2][1][g[i]] + m[2][2][b[i]] + color->offset[2]) >> 8;
+
+            r[i] = color->lut[0][SDL_clamp(red, 0, 255)];
+            g[i] = color->lut[1][SDL_clamp(green, 0, 255)];
+            b[i] = color->lut[2][SDL_clamp(blue, 0, 255)];
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        r[i] = color->lut[0][r[i]];
+        g[i] = color->lut[1][g[i]];
+        b[i] = color->lut[2][b[i]];
+    }
+}
+
+/* Without an alpha row, formats with alpha are filled opaque */
+static void GleedPackRGBRow(const GleedPixelLayout *layout, const Uint8 *r, const Uint8 *g, const Uint8 *b, const Uint8 *a, bool premultiply, Uint8 *dst, int count)
+{
+    if (layout->a < 0 || !a)
+    {
+        /* Unused byte is written too, so the result is opaque even if it is drawn as the alpha-carrying variant */
+        const int opaque = layout->a >= 0 ? layout->a : layout->x;
+
+        for (int i = 0; i < count; i++)
+        {
+            dst[layout->r] = r[i];
+            dst[layout->g] = g[i];
+            dst[layout->b] = b[i];
+
+            if (opaque >= 0)
+                dst[opaque] = 255;
+
+            dst += layout->bytes_per_pixel;
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (premultiply)
+        {
+            /* x * a / 255, exact for all 8-bit inputs */
+            const int alpha = a[i];
+            int t;
+
+            t = r[i] * alpha + 128;
+            dst[layout->r] = (Uint8)((t + (t >> 8)) >> 8);
+            t = g[i] * alpha + 128;
+            dst[layout->g] = (Uint8)((t + (t >> 8)) >> 8);
+            t = b[i] * alpha + 128;
+            dst[layout->b] = (Uint8)((t + (t >> 8)) >> 8);
+        }
+        else
+        {
+            dst[layout->r] = r[i];
+            dst[layout->g] = g[i];
+            dst[layout->b] = b[i];
+        }
+
+        dst[layout->a] = a[i];
+        dst += layout->bytes_per_pixel;
+    }
+}
+
+/* Averages 2x2 source pixels into dst pixels from x on; a level 1 pixel wide reuses its only column */
+static void GleedReduceMipRowScalar(const Uint8 *r0, const Uint8 *r1, int bytes_per_pixel, int src_w, Uint8 *dst, int x, int count)
+{
+    for (; x < count; x++)
+    {
+        const Uint8 *p0 = r0 + 2 * x * bytes_per_pixel;
+        const Uint8 *p1 = r1 + 2 * x * bytes_per_pixel;
+        const int next = 2 * x + 1 < src_w ? bytes_per_pixel : 0;
+
+        for (int c = 0; c < bytes_per_pixel; c++)
+        {
+            dst[x * bytes_per_pixel + c] = (Uint8)((p0[c] + p0[c + next] + p1[c] + p1[c + next] + 2) >> 2);
+        }
+    }
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+/* 32-bit pixels only, the source row must hold two pixels for every one of dst */
+static void SDL_TARGETING("sse2") GleedReduceMipRow32SSE2(const Uint8 *r0, const Uint8 *r1, int src_w, Uint8 *dst, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+
+    int x = 0;
+
+    for (; x + 4 <= count; x += 4)
+    {
+        const __m128i a0 = _mm_loadu_si128((const __m128i *)(r0 + x * 8));
+        const __m128i a1 = _mm_loadu_si128((const __m128i *)(r0 + x * 8 + 16));
+        const __m128i b0 = _mm_loadu_si128((const __m128i *)(r1 + x * 8));
+        const __m128i b1 = _mm_loadu_si128((const __m128i *)(r1 + x * 8 + 16));
+
+        /* Vertical sums, two source pixels per register */
+        const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        /* Horizontal sums, the even pixels of two registers plus their odd neighbours */
+        const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        const __m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+        _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, two), 2), _mm_srli_epi16(_mm_add_epi16(hi, two), 2)));
+    }
+
+    GleedReduceMipRowScalar(r0, r1, 4, src_w, dst, x, count);
+}
+#endif
+
+/* Called once a row of the full size level is finished, fills the rows of the smaller levels it completes */
+static void GleedReduceMipRows(SDL_Surface *const *levels, int level_count, int bytes_per_pixel, int row)
+{
+    for (int level = 0; level + 1 < level_count; level++)
+    {
+        const SDL_Surface *src = levels[level];
+        SDL_Surface *dst = levels[level + 1];
+
+        /* Second row of a pair completes a row below, a trailing odd row is left out, as a box filter drops it */
+        if (src->h > 1 && !(row & 1))
+            return;
+
+        row >>= 1;
+
+        const Uint8 *r0 = (const Uint8 *)src->pixels + (size_t)SDL_min(2 * row, src->h - 1) * src->pitch;
+        const Uint8 *r1 = (const Uint8 *)src->pixels + (size_t)SDL_min(2 * row + 1, src->h - 1) * src->pitch;
+        Uint8 *dst_row = (Uint8 *)dst->pixels + (size_t)row * dst->pitch;
+
+#ifdef SDL_SSE2_INTRINSICS
+        if (bytes_per_pixel == 4 && src->w >= 2 && SDL_HasSSE2())
+        {
+            GleedReduceMipRow32SSE2(r0, r1, src->w, dst_row, dst->w);
+            continue;
+        }
+#endif
+
+        GleedReduceMipRowScalar(r0, r1, bytes_per_pixel, src->w, dst_row, 0, dst->w);
+    }
+}
+
+static void GleedConvertRows(const GleedVideoFrameYUV *src, const GleedVideoFrameYUV *alpha, const SDL_Rect *crop, const GleedConvertParams *params, const GleedYUVMatrix *matrix, GleedYUVToRGBKernel kernel, const GleedPixelLayout *layout, SDL_Surface *dst, SDL_Surface *const *levels, int level_count)
+{
+    Sint16 y[GLEED_CONVERT_CHUNK];
+    Sint16 u[GLEED_CONVERT_CHUNK];
+    Sint16 v[GLEED_CONVERT_CHUNK];
+    Uint8 r[GLEED_CONVERT_CHUNK];
+    Uint8 g[GLEED_CONVERT_CHUNK];
+    Uint8 b[GLEED_CONVERT_CHUNK];
+    Uint8 a[GLEED_CONVERT_CHUNK];
+    Sint16 rounding[8];
+
+    for (int row = 0; row < dst->h; row++)
+    {
+        Uint8 *dst_row = (Uint8 *)dst->pixels + row * dst->pitch;
+
+        GleedGetRowRounding(src->bit_depth, params->fast, row, rounding);
+
+        for (int x = 0; x < dst->w; x += GLEED_CONVERT_CHUNK)
+        {
+            const int count = SDL_min(GLEED_CONVERT_CHUNK, dst->w - x);
+
+            GleedUnpackYUVRow(src, crop->y + row, crop->x + x, count, y, u, v);
+            kernel(matrix, y, u, v, rounding, r, g, b, count);
+
+            if (alpha)
+            {
+                GleedUnpackAlphaRow(alpha, crop->y + row, crop->x + x, count, a);
+            }
+
+            if (params->color)
+            {
+                GleedApplyColorTransform(params->color, r, g, b, count);
+            }
+
+            GleedPackRGBRow(layout, r, g, b, alpha ? a : NULL, params->premultiply, dst_row + x * layout->bytes_per_pixel, count);
+        }
+
+        GleedReduceMipRows(levels, level_count, layout->bytes_per_pixel, row);
+    }
+}
+
+/* Scaling runs on whatever thread converts (player, decode-ahead, range workers), so each thread keeps its own scratch */
+typedef struct
+{
+    Uint8 *data; /**< Taps and filtered rows of the last scaled frame */
+    size_t size; /**< Capacity of data, only ever grows */
+} GleedScaleScratch;
+
+static SDL_TLSID gleed_scale_scratch;
+
+static void GleedFreeScaleScratch(void *data)
+{
+    GleedScaleScratch *scratch = (GleedScaleScratch *)data;
+
+    SDL_free(scratch->data);
+    SDL_free(scratch);
+}
+
+static Uint8 *GleedGetScaleScratch(size_t size)
+{
+    GleedScaleScratch *scratch = (GleedScaleScratch *)SDL_GetTLS(&gleed_scale_scratch);
+
+    if (!scratch)
+    {
+        scratch = (GleedScaleScratch *)SDL_calloc(1, sizeof(GleedScaleScratch));
+
+        if (!scratch)
+            return NULL;
+
+        if (!SDL_SetTLS(&gleed_scale_scratch, scratch, GleedFreeScaleScratch))
+        {
+            SDL_free(scratch);
+            return NULL;
+        }
+    }
+
+    if (scratch->size < size)
+    {
+        Uint8 *data = (Uint8 *)SDL_realloc(scratch->data, size);
+
+        if (!data)
+            return NULL;
+
+        scratch->data = data;
+        scratch->size = size;
+    }
+
+    return scratch->data;
+}
+
+static bool GleedConvertScaledRows(const GleedVideoFrameYUV *src, const GleedVideoFrameYUV *alpha, const SDL_Rect *crop, const GleedConvertParams *params, const GleedYUVMatrix *matrix, GleedYUVToRGBKernel kernel, const GleedPixelLayout *layout, SDL_Surface *dst, SDL_Surface *const *levels, int level_count)
+{
+    const bool box_x = !params->fast && crop->w >= 2 * dst->w;
+    const bool box_y = !params->fast && crop->h >= 2 * dst->h;
+
+    const int sx = src->chroma_shift_x;
+    const int sy = src->chroma_shift_y;
+
+    /* Plane columns covered by the crop, only those are filtered vertically */
+    const int luma_start = crop->x;
+    const int luma_count = crop->w;
+    const int chroma_start = crop->x >> sx;
+    const int chroma_count = ((crop->x + crop->w + (1 << sx) - 1) >> sx) - chroma_start;
+
+    /* Horizontal taps are the same for every row, vertically filtered rows are reused for each chunk */
+    const size_t taps_size = (size_t)dst->w * sizeof(GleedScaleTap);
+    const size_t rows_size = (size_t)(2 * luma_count + 2 * chroma_count) * sizeof(Sint16);
+
+    Uint8 *scratch = GleedGetScaleScratch(2 * taps_size + rows_size);
+
+    if (!scratch)
+    {
+        return GleedSetError("Failed to allocate memory for video scaling");
+    }
+
+    GleedScaleTap *luma_taps = (GleedScaleTap *)scratch;
+    GleedScaleTap *chroma_taps = (GleedScaleTap *)(scratch + taps_size);
+    Sint16 *luma_row = (Sint16 *)(scratch + 2 * taps_size);
+    Sint16 *u_row = luma_row + luma_count;
+    Sint16 *v_row = u_row + chroma_count;
+    Sint16 *alpha_row = v_row + chroma_count;
+
+    for (int x = 0; x < dst->w; x++)
+    {
+        GleedGetScaleTap(crop->x, crop->w, dst->w, 0, box_x, x, &luma_taps[x]);
+        GleedGetScaleTap(crop->x, crop->w, dst->w, sx, box_x, x, &chroma_taps[x]);
+
+        if (params->fast)
+        {
+            GleedSnapScaleTap(&luma_taps[x]);
+            GleedSnapScaleTap(&chroma_taps[x]);
+        }
+    }
+
+    Sint16 y[GLEED_CONVERT_CHUNK];
+    Sint16 u[GLEED_CONVERT_CHUNK];
+    Sint16 v[GLEED_CONVERT_CHUNK];
+    Uint8 r[GLEED_CONVERT_CHUNK];
+    Uint8 g[GLEED_CONVERT_CHUNK];
+    Uint8 b[GLEED_CONVERT_CHUNK];
+    Uint8 a[GLEED_CONVERT_CHUNK];
+    Sint16 rounding[8];
+
+    for (int row = 0; row < dst->h; row++)
+    {
+        GleedScaleTap luma_tap;
+        GleedScaleTap chroma_tap;
+
+        GleedGetScaleTap(crop->y, crop->h, dst->h, 0, box_y, row, &luma_tap);
+        GleedGetScaleTap(crop->y, crop->h, dst->h, sy, box_y, row, &chroma_tap);
+
+        if (params->fast)
+        {
+            GleedSnapScaleTap(&luma_tap);
+            GleedSnapScaleTap(&chroma_tap);
+        }
+
+        GleedResamplePlaneRow(src->planes[0], src->pitches[0], src->bit_depth, &luma_tap, box_y, luma_start, luma_count, luma_row);
+        GleedResamplePlaneRow(src->planes[1], src->pitches[1], src->bit_depth, &chroma_tap, box_y, chroma_start, chroma_count, u_row);
+        GleedResamplePlaneRow(src->planes[2], src->pitches[2], src->bit_depth, &chroma_tap, box_y, chroma_start, chroma_count, v_row);
+
+        if (alpha)
+        {
+            GleedResamplePlaneRow(alpha->planes[0], alpha->pitches[0], alpha->bit_depth, &luma_tap, box_y, luma_start, luma_count, alpha_row);
+        }
+
+        Uint8 *dst_row = (Uint8 *)dst->pixels + row * dst->pitch;
+
+        GleedGetRowRounding(src->bit_depth, params->fast, row, rounding);
+
+        for (int x = 0; x < dst->w; x += GLEED_CONVERT_CHUNK)
+        {
+            const int count = SDL_min(GLEED_CONVERT_CHUNK, dst->w - x);
+
+            GleedResampleRow(luma_row, luma_start, luma_taps + x, box_x, y, count);
+            GleedResampleRow(u_row, chroma_start, chroma_taps + x, box_x, u, count);
+            GleedResampleRow(v_row, chroma_start, chroma_taps + x, box_x, v, count);
+
+            kernel(matrix, y, u, v, rounding, r, g, b, count);
+
+            if (alpha)
+            {
+                /* Luma chunk buffer is free again after the kernel, alpha borrows it */
+                GleedResampleRow(alpha_row, luma_start, luma_taps + x, box_x, y, count);
+                GleedSamplesToAlpha(y, a, count);
+            }
+
+            if (params->color)
+            {
+                GleedApplyColorTransform(params->color, r, g, b, count);
+            }
+
+            GleedPackRGBRow(layout, r, g, b, alpha ? a : NULL, params->premultiply, dst_row + x * layout->bytes_per_pixel, count);
+        }
+
+        GleedReduceMipRows(levels, level_count, layout->bytes_per_pixel, row);
+    }
+
+    return true;
+}
+
+GleedColorTransformTables *GleedCompileColorTransform(const GleedColorTransform *transform)
+{
+    GleedColorTransformTables *tables = (GleedColorTransformTables *)SDL_calloc(1, sizeof(GleedColorTransformTables));
+
+    if (!tables)
+    {
+        GleedSetError("Failed to allocate memory for colour transform");
+        return NULL;
+    }
+
+    SDL_SetAtomicInt(&tables->refcount, 1);
+
+    tables->has_matrix = transform->use_matrix;
+
+    if (tables->has_matrix)
+    {
+        for (int out = 0; out < 3; out++)
+        {
+            for (int in = 0; in < 3; in++)
+            {
+                for (int v = 0; v < 256; v++)
+                {
+                    tables->matrix[out][in][v] = (Sint32)SDL_floorf(transform->matrix[out][in] * v * 256.0f + 0.5f);
+                }
+            }
+
+            tables->offset[out] = (Sint32)SDL_floorf(transform->matrix[out][3] * 255.0f * 256.0f + 0.5f) + 128;
+        }
+    }
+
+    /* Fade comes last, it's a blend of the looked up value with a constant, so it folds into the same table */
+    const float fade = SDL_clamp(transform->fade, 0.0f, 1.0f);
+    const float fade_color[3] = {transform->fade_color.r, transform->fade_color.g, transform->fade_color.b};
+
+    for (int c = 0; c < 3; c++)
+    {
+        const float target = SDL_clamp(fade_color[c], 0.0f, 1.0f) * 255.0f;
+
+        for (int v = 0; v < 256; v++)
+        {
+            const float value = transform->use_lut ? transform->lut[c][v] : (float)v;
+
+            tables->lut[c][v] = (Uint8)SDL_floorf(value + (target - value) * fade + 0.5f);
+        }
+    }
+
+    return tables;
+}
+
+void GleedReleaseColorTransform(GleedColorTransformTables *tables)
+{
+    if (tables && SDL_AtomicDecRef(&tables->refcount))
+    {
+        SDL_free(tables);
+    }
+}
+
+void GleedSetColorTransformGamma(GleedColorTransform *transform, float gamma)
+{
+    if (!transform || gamma <= 0.0f)
+    {
+        return;
+    }
+
+    for (int v = 0; v < 256; v++)
+    {
+        const Uint8 value = (Uint8)SDL_floorf(SDL_powf(v / 255.0f, 1.0f / gamma) * 255.0f + 0.5f);
+
+        transform->lut[0][v] = transform->lut[1][v] = transform->lut[2][v] = value;
+    }
+
+    transform->use_lut = true;
+}
+
+/*
+    Returns the surface followed by its mip levels, largest first, to be freed with SDL_free.
+    Levels from a previous frame are reused, they only get replaced when the surface size or format changed.
+*/
+static SDL_Surface **GleedGetSurfaceMipChain(SDL_Surface *surface, int *level_count)
+{
+    int count = 1;
+
+    for (int w = surface->w, h = surface->h; w > 1 || h > 1; count++)
+    {
+        w = SDL_max(w >> 1, 1);
+        h = SDL_max(h >> 1, 1);
+    }
+
+    int image_count = 0;
+    SDL_Surface **images = SDL_GetSurfaceImages(surface, &image_count);
+
+    bool valid = images && image_count == count;
+
+    for (int i = 1; valid && i < count; i++)
+    {
+        valid = images[i]->format == surface->format &&
+                images[i]->w == SDL_max(surface->w >> i, 1) &&
+                images[i]->h == SDL_max(surface->h >> i, 1);
+    }
+
+    if (valid)
+    {
+        *level_count = count;
+        return images;
+    }
+
+    SDL_free(images);
+    SDL_RemoveSurfaceAlternateImages(surface);
+
+    for (int i = 1; i < count; i++)
+    {
+        SDL_Surface *level = SDL_CreateSurface(SDL_max(surface->w >> i, 1), SDL_max(surface->h >> i, 1), surface->format);
+
+        /* Surface keeps its own reference to the level */
+        const bool added = level && SDL_AddSurfaceAlternateImage(surface, level);
+
+        SDL_DestroySurface(level);
+
+        if (!added)
+        {
+            SDL_RemoveSurfaceAlternateImages(surface);
+            GleedSetError("Failed to create video frame mip level: %s", SDL_GetError());
+            return NULL;
+        }
+    }
+
+    images = SDL_GetSurfaceImages(surface, &image_count);
+
+    if (!images)
+    {
+        GleedSetError("Failed to get video frame mip levels: %s", SDL_GetError());
+        return NULL;
+    }
+
+    *level_count = image_count;
+
+    return images;
+}
+
+bool GleedGenerateSurfaceMipmaps(SDL_Surface *surface)
+{
+    GleedPixelLayout layout;
+
+    if (!GleedGetPixelLayout(surface->format, &layout))
+    {
+        return GleedSetError("Unsupported output pixel format: %s", SDL_GetPixelFormatName(surface->format));
+    }
+
+    int level_count;
+    SDL_Surface **levels = GleedGetSurfaceMipChain(surface, &level_count);
+
+    if (!levels)
+    {
+        return false;
+    }
+
+    if (!SDL_LockSurface(surface))
+    {
+        SDL_free(levels);
+        return GleedSetError("Failed to lock video frame surface: %s", SDL_GetError());
+    }
+
+    for (int row = 0; row < surface->h; row++)
+    {
+        GleedReduceMipRows(levels, level_count, layout.bytes_per_pixel, row);
+    }
+
+    SDL_UnlockSurface(surface);
+    SDL_free(levels);
+
+    return true;
+}
+
+bool GleedIsVideoOutputFormatSupported(SDL_PixelFormat format)
+{
+    GleedPixelLayout layout;
+
+    return GleedGetPixelLayout(format, &layout);
+}
+
+bool GleedConvertYUVFrame(const GleedVideoFrameYUV *src, const GleedVideoFrameYUV *alpha, const GleedConvertParams *params, SDL_Surface *dst)
+{
+    if (!src || !params || !dst)
+    {
+        return GleedSetError("Invalid frame or target surface");
+    }
+
+    if (src->bit_depth != 8 && src->bit_depth != 10 && src->bit_depth != 12)
+    {
+        return GleedSetError("Unsupported video bit depth: %d", src->bit_depth);
+    }
+
+    GleedPixelLayout layout;
+
+    if (!GleedGetPixelLayout(dst->format, &layout))
+    {
+        return GleedSetError("Unsupported output pixel format: %s", SDL_GetPixelFormatName(dst->format));
+    }
+
+    /* Crop is given in track pixels, but resolution may change mid-stream, so it's clipped to the frame */
+    const SDL_Rect frame_rect = {0, 0, src->w, src->h};
+
+    SDL_Rect source_rect = frame_rect;
+
+    if (params->crop && !SDL_GetRectIntersection(params->crop, &frame_rect, &source_rect))
+    {
+        source_rect = frame_rect;
+    }
+
+    /* Alpha stream is encoded at the colour size, anything else can't be merged pixel by pixel */
+    if (alpha && (layout.a < 0 || alpha->w != src->w || alpha->h != src->h))
+    {
+        alpha = NULL;
+    }
+
+    GleedYUVMatrix matrix;
+    GleedGetYUVMatrix(src->colorspace, &matrix);
+
+    const GleedYUVToRGBKernel kernel = GleedGetYUVToRGBKernel();
+
+    int level_count = 0;
+    SDL_Surface **levels = NULL;
+
+    if (params->mipmaps)
+    {
+        levels = GleedGetSurfaceMipChain(dst, &level_count);
+
+        if (!levels)
+        {
+            return false;
+        }
+    }
+
+    if (!SDL_LockSurface(dst))
+    {
+        SDL_free(levels);
+        return GleedSetError("Failed to lock target surface: %s", SDL_GetError());
+    }
+
+    bool result = true;
+
+    if (source_rect.w == dst->w && source_rect.h == dst->h)
+    {
+        GleedConvertRows(src, alpha, &source_rect, params, &matrix, kernel, &layout, dst, levels, level_count);
+    }
+    else
+    {
+        result = GleedConvertScaledRows(src, alpha, &source_rect, params, &matrix, kernel, &layout, dst, levels, level_count);
+    }
+
+    SDL_UnlockSurface(dst);
+    SDL_free(levels);
+
+    return result;
+}
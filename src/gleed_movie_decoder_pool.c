@@ -0,0 +1,131 @@
+#include "gleed_movie_internal.h"
+
+/* A couple of cutscenes or UI movies in flight, without holding on to much decoder memory */
+#define GLEED_DECODER_POOL_DEFAULT_LIMIT 4
+
+typedef struct GleedPooledDecoder
+{
+    GleedPooledDecoderType type;        /**< Kind of context */
+    Uint64 key;                         /**< Contexts are only handed out for an equal key */
+    void *context;                      /**< Parked decoder context, already reset */
+    GleedDestroyPooledDecoder destroy;  /**< Frees the context when it is trimmed */
+    struct GleedPooledDecoder *next;    /**< Next parked context, older ones come later */
+} GleedPooledDecoder;
+
+/* Movies may be opened and freed on any thread, list updates are short so a spinlock is enough */
+static SDL_SpinLock pool_lock;
+static GleedPooledDecoder *pool_head; /**< Most recently parked context */
+static int pool_count;
+static int pool_limit = GLEED_DECODER_POOL_DEFAULT_LIMIT;
+
+static void GleedDestroyPooledDecoders(GleedPooledDecoder *list)
+{
+    while (list)
+    {
+        GleedPooledDecoder *next = list->next;
+        list->destroy(list->context);
+        SDL_free(list);
+        list = next;
+    }
+}
+
+/* Called with the lock held, returns the unlinked entries beyond the limit, so they can be destroyed outside of it */
+static GleedPooledDecoder *GleedCutDecoderPool(int limit)
+{
+    GleedPooledDecoder **link = &pool_head;
+
+    for (int i = 0; i < limit && *link; i++)
+    {
+        link = &(*link)->next;
+    }
+
+    GleedPooledDecoder *cut = *link;
+    *link = NULL;
+
+    pool_count = SDL_min(pool_count, limit);
+
+    return cut;
+}
+
+void *GleedTakePooledDecoder(GleedPooledDecoderType type, Uint64 key)
+{
+    SDL_LockSpinlock(&pool_lock);
+
+    GleedPooledDecoder **link = &pool_head;
+
+    while (*link && ((*link)->type != type || (*link)->key != key))
+    {
+        link = &(*link)->next;
+    }
+
+    GleedPooledDecoder *entry = *link;
+
+    if (entry)
+    {
+        *link = entry->next;
+        pool_count--;
+    }
+
+    SDL_UnlockSpinlock(&pool_lock);
+
+    if (!entry)
+        return NULL;
+
+    void *context = entry->context;
+    SDL_free(entry);
+
+    return context;
+}
+
+void GleedParkPooledDecoder(GleedPooledDecoderType type, Uint64 key, void *context, GleedDestroyPooledDecoder destroy)
+{
+    GleedPooledDecoder *entry = (GleedPooledDecoder *)SDL_calloc(1, sizeof(GleedPooledDecoder));
+
+    if (!entry)
+    {
+        destroy(context);
+        return;
+    }
+
+    entry->type = type;
+    entry->key = key;
+    entry->context = context;
+    entry->destroy = destroy;
+
+    SDL_LockSpinlock(&pool_lock);
+
+    entry->next = pool_head;
+    pool_head = entry;
+    pool_count++;
+
+    /* Least recently parked contexts go first, they are the least likely to match the next movie */
+    GleedPooledDecoder *trimmed = pool_count > pool_limit ? GleedCutDecoderPool(pool_limit) : NULL;
+
+    SDL_UnlockSpinlock(&pool_lock);
+
+    GleedDestroyPooledDecoders(trimmed);
+}
+
+void GleedSetDecoderPoolLimit(int count)
+{
+    SDL_LockSpinlock(&pool_lock);
+
+    pool_limit = SDL_max(count, 0);
+
+    GleedPooledDecoder *trimmed = GleedCutDecoderPool(pool_limit);
+
+    SDL_UnlockSpinlock(&pool_lock);
+
+    GleedDestroyPooledDecoders(trimmed);
+}
+
+void GleedTrimDecoderPool(void)
+{
+    SDL_LockSpinlock(&pool_lock);
+
+    GleedPooledDecoder *trimmed = GleedCutDecoderPool(0);
+
+    SDL_UnlockSpinlock(&pool_lock);
+
+    GleedDestroyPooledDecoders(trimmed);
+}
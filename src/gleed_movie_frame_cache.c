@@ -0,0 +1,228 @@
+#include "gleed_movie_internal.h"
+
+#define GLEED_FRAME_CACHE_BUCKETS 256
+
+/* Holds a few seconds of 1080p RGB24 frames, enough for movies played in several places at once */
+#define GLEED_FRAME_CACHE_DEFAULT_LIMIT (64 * 1024 * 1024)
+
+/*
+    Cache is shared by every movie in the process, possibly from several decoder threads.
+    Lookups and list updates are short, pixels are copied outside of the lock.
+*/
+static SDL_SpinLock cache_lock;
+static GleedFrameCacheEntry *cache_buckets[GLEED_FRAME_CACHE_BUCKETS];
+static GleedFrameCacheEntry *cache_lru_head; /**< Most recently used entry */
+static GleedFrameCacheEntry *cache_lru_tail; /**< Least recently used entry, evicted first */
+static size_t cache_size;
+static size_t cache_limit = GLEED_FRAME_CACHE_DEFAULT_LIMIT;
+
+static Uint32 GleedHashFrameCacheKey(const GleedFrameCacheKey *key)
+{
+    /* Frame index varies the most between entries, fingerprint tells files apart */
+    const Uint64 hash = key->fingerprint ^ ((Uint64)key->frame * 0x9E3779B97F4A7C15ull) ^ ((Uint64)key->track << 56);
+
+    return (Uint32)(hash ^ (hash >> 32)) % GLEED_FRAME_CACHE_BUCKETS;
+}
+
+static void GleedUnlinkFrameCacheLRU(GleedFrameCacheEntry *entry)
+{
+    if (entry->lru_prev)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache_lru_head = entry->lru_next;
+
+    if (entry->lru_next)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache_lru_tail = entry->lru_prev;
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void GleedPushFrameCacheLRU(GleedFrameCacheEntry *entry)
+{
+    entry->lru_next = cache_lru_head;
+
+    if (cache_lru_head)
+        cache_lru_head->lru_prev = entry;
+    else
+        cache_lru_tail = entry;
+
+    cache_lru_head = entry;
+}
+
+static GleedFrameCacheEntry *GleedFindFrameCacheEntry(const GleedFrameCacheKey *key, GleedFrameCacheEntry ***link)
+{
+    GleedFrameCacheEntry **it = &cache_buckets[GleedHashFrameCacheKey(key)];
+
+    while (*it && SDL_memcmp(&(*it)->key, key, sizeof(GleedFrameCacheKey)) != 0)
+    {
+        it = &(*it)->hash_next;
+    }
+
+    if (link)
+        *link = it;
+
+    return *it;
+}
+
+/* Takes the entry out of the cache; returns true if nobody else holds it, so it can be freed right away */
+static bool GleedRemoveFrameCacheEntry(GleedFrameCacheEntry *entry)
+{
+    GleedFrameCacheEntry **link;
+    GleedFindFrameCacheEntry(&entry->key, &link);
+
+    *link = entry->hash_next;
+    GleedUnlinkFrameCacheLRU(entry);
+    cache_size -= entry->size;
+
+    return SDL_AtomicDecRef(&entry->refcount);
+}
+
+static void GleedFreeFrameCacheEntry(GleedFrameCacheEntry *entry)
+{
+    SDL_DestroySurface(entry->surface);
+    SDL_free(entry);
+}
+
+/* Called with the lock held; entries still in use are only unlinked, their last user frees them */
+static GleedFrameCacheEntry *GleedEvictFrameCache(size_t limit)
+{
+    GleedFrameCacheEntry *evicted = NULL;
+
+    while (cache_lru_tail && cache_size > limit)
+    {
+        GleedFrameCacheEntry *entry = cache_lru_tail;
+
+        if (GleedRemoveFrameCacheEntry(entry))
+        {
+            entry->hash_next = evicted;
+            evicted = entry;
+        }
+    }
+
+    return evicted;
+}
+
+static void GleedFreeEvictedFrameCacheEntries(GleedFrameCacheEntry *evicted)
+{
+    while (evicted)
+    {
+        GleedFrameCacheEntry *next = evicted->hash_next;
+        GleedFreeFrameCacheEntry(evicted);
+        evicted = next;
+    }
+}
+
+GleedFrameCacheEntry *GleedAcquireFrameCacheEntry(const GleedFrameCacheKey *key)
+{
+    SDL_LockSpinlock(&cache_lock);
+
+    GleedFrameCacheEntry *entry = GleedFindFrameCacheEntry(key, NULL);
+
+    if (entry)
+    {
+        SDL_AtomicIncRef(&entry->refcount);
+
+        GleedUnlinkFrameCacheLRU(entry);
+        GleedPushFrameCacheLRU(entry);
+    }
+
+    SDL_UnlockSpinlock(&cache_lock);
+
+    return entry;
+}
+
+void GleedReleaseFrameCacheEntry(GleedFrameCacheEntry *entry)
+{
+    if (!entry)
+        return;
+
+    /* Cache holds its own reference, so reaching zero means the entry was evicted already */
+    if (SDL_AtomicDecRef(&entry->refcount))
+    {
+        GleedFreeFrameCacheEntry(entry);
+    }
+}
+
+void GleedAddFrameCacheEntry(const GleedFrameCacheKey *key, const SDL_Surface *surface)
+{
+    const size_t size = (size_t)surface->pitch * surface->h;
+
+    SDL_LockSpinlock(&cache_lock);
+
+    const bool fits = size <= cache_limit;
+
+    SDL_UnlockSpinlock(&cache_lock);
+
+    if (!fits)
+        return;
+
+    GleedFrameCacheEntry *entry = (GleedFrameCacheEntry *)SDL_calloc(1, sizeof(GleedFrameCacheEntry));
+
+    if (!entry)
+        return;
+
+    /* Cache is best effort, a frame that can't be copied is simply not shared */
+    entry->surface = SDL_DuplicateSurface((SDL_Surface *)surface);
+
+    if (!entry->surface)
+    {
+        SDL_free(entry);
+        return;
+    }
+
+    /* Mip levels come along with the duplicate, but users regenerate them anyway, so they would only eat the budget */
+    SDL_RemoveSurfaceAlternateImages(entry->surface);
+
+    entry->key = *key;
+    entry->size = size;
+    SDL_SetAtomicInt(&entry->refcount, 1);
+
+    SDL_LockSpinlock(&cache_lock);
+
+    /* Another instance may have converted the same frame meanwhile */
+    GleedFrameCacheEntry **link;
+
+    if (GleedFindFrameCacheEntry(key, &link))
+    {
+        SDL_UnlockSpinlock(&cache_lock);
+        GleedFreeFrameCacheEntry(entry);
+        return;
+    }
+
+    *link = entry;
+    GleedPushFrameCacheLRU(entry);
+    cache_size += size;
+
+    GleedFrameCacheEntry *evicted = GleedEvictFrameCache(cache_limit);
+
+    SDL_UnlockSpinlock(&cache_lock);
+
+    GleedFreeEvictedFrameCacheEntries(evicted);
+}
+
+void GleedSetVideoFrameCacheLimit(size_t bytes)
+{
+    SDL_LockSpinlock(&cache_lock);
+
+    cache_limit = bytes;
+
+    GleedFrameCacheEntry *evicted = GleedEvictFrameCache(cache_limit);
+
+    SDL_UnlockSpinlock(&cache_lock);
+
+    GleedFreeEvictedFrameCacheEntries(evicted);
+}
+
+void GleedClearVideoFrameCache(void)
+{
+    SDL_LockSpinlock(&cache_lock);
+
+    GleedFrameCacheEntry *evicted = GleedEvictFrameCache(0);
+
+    SDL_UnlockSpinlock(&cache_lock);
+
+    GleedFreeEvictedFrameCacheEntries(evicted);
+}
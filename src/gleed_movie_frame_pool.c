@@ -0,0 +1,160 @@
+#include "gleed_movie_internal.h"
+
+static void GleedFreeFrameBuffer(GleedFrameBuffer *buffer)
+{
+    SDL_aligned_free(buffer->data);
+    SDL_free(buffer);
+}
+
+GleedFrameBufferPool *GleedCreateFrameBufferPool(size_t buffer_size)
+{
+    GleedFrameBufferPool *pool = (GleedFrameBufferPool *)SDL_calloc(1, sizeof(GleedFrameBufferPool));
+
+    if (!pool)
+    {
+        GleedSetError("Failed to allocate memory for frame buffer pool");
+        return NULL;
+    }
+
+    pool->lock = SDL_CreateMutex();
+
+    if (!pool->lock)
+    {
+        GleedSetError("Failed to create frame buffer pool lock: %s", SDL_GetError());
+        SDL_free(pool);
+        return NULL;
+    }
+
+    pool->buffer_size = buffer_size;
+    SDL_SetAtomicInt(&pool->refcount, 1);
+
+    return pool;
+}
+
+void GleedRetainFrameBufferPool(GleedFrameBufferPool *pool)
+{
+    SDL_AtomicIncRef(&pool->refcount);
+}
+
+void GleedReleaseFrameBufferPool(GleedFrameBufferPool *pool)
+{
+    if (!pool)
+        return;
+
+    if (!SDL_AtomicDecRef(&pool->refcount))
+        return;
+
+    /* Nobody can hold a buffer anymore: the decoder is gone and every acquired frame held a pool reference */
+    for (int i = 0; i < pool->count; i++)
+    {
+        GleedFreeFrameBuffer(pool->buffers[i]);
+    }
+
+    SDL_free(pool->buffers);
+    SDL_DestroyMutex(pool->lock);
+    SDL_free(pool);
+}
+
+GleedFrameBuffer *GleedGetFrameBuffer(GleedFrameBufferPool *pool, size_t min_size)
+{
+    SDL_LockMutex(pool->lock);
+
+    GleedFrameBuffer *free_buffer = NULL;
+
+    for (int i = 0; i < pool->count; i++)
+    {
+        GleedFrameBuffer *buffer = pool->buffers[i];
+
+        if (SDL_GetAtomicInt(&buffer->refcount) != 0)
+            continue;
+
+        if (buffer->size >= min_size)
+        {
+            SDL_SetAtomicInt(&buffer->refcount, 1);
+            SDL_UnlockMutex(pool->lock);
+            return buffer;
+        }
+
+        free_buffer = buffer;
+    }
+
+    /*
+        Nothing big enough is free. If a smaller buffer is (resolution went up),
+        its memory is replaced instead of growing the pool with buffers that would never fit again.
+    */
+    const size_t size = SDL_max(min_size, pool->buffer_size);
+
+    Uint8 *data = (Uint8 *)SDL_aligned_alloc(SDL_GetSIMDAlignment(), size);
+
+    if (!data)
+    {
+        SDL_UnlockMutex(pool->lock);
+        GleedSetError("Failed to allocate frame buffer of %u bytes", (Uint32)size);
+        return NULL;
+    }
+
+    /* Decoder may read padding it has never written, keep it deterministic */
+    SDL_memset(data, 0, size);
+
+    if (free_buffer)
+    {
+        SDL_aligned_free(free_buffer->data);
+        free_buffer->data = data;
+        free_buffer->size = size;
+        SDL_SetAtomicInt(&free_buffer->refcount, 1);
+        SDL_UnlockMutex(pool->lock);
+        return free_buffer;
+    }
+
+    if (pool->count >= pool->capacity)
+    {
+        const int new_capacity = pool->capacity ? pool->capacity * 2 : 8;
+
+        GleedFrameBuffer **new_buffers = (GleedFrameBuffer **)SDL_realloc(pool->buffers, new_capacity * sizeof(GleedFrameBuffer *));
+
+        if (!new_buffers)
+        {
+            SDL_aligned_free(data);
+            SDL_UnlockMutex(pool->lock);
+            GleedSetError("Failed to grow frame buffer pool");
+            return NULL;
+        }
+
+        pool->buffers = new_buffers;
+        pool->capacity = new_capacity;
+    }
+
+    GleedFrameBuffer *buffer = (GleedFrameBuffer *)SDL_calloc(1, sizeof(GleedFrameBuffer));
+
+    if (!buffer)
+    {
+        SDL_aligned_free(data);
+        SDL_UnlockMutex(pool->lock);
+        GleedSetError("Failed to allocate frame buffer");
+        return NULL;
+    }
+
+    buffer->data = data;
+    buffer->size = size;
+    SDL_SetAtomicInt(&buffer->refcount, 1);
+
+    pool->buffers[pool->count++] = buffer;
+
+    SDL_UnlockMutex(pool->lock);
+
+    return buffer;
+}
+
+void GleedRetainFrameBuffer(GleedFrameBuffer *buffer)
+{
+    SDL_AtomicIncRef(&buffer->refcount);
+}
+
+void GleedReleaseFrameBuffer(GleedFrameBuffer *buffer)
+{
+    if (!buffer)
+        return;
+
+    /* Buffer simply becomes free at zero, memory stays in the pool for the next frame */
+    SDL_AddAtomicInt(&buffer->refcount, -1);
+}
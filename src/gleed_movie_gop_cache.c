@@ -0,0 +1,601 @@
+#include "gleed_movie_internal.h"
+
+/* Two second-long groups of 1080p pictures at 30 fps: the one being scrubbed, and its neighbour prefetched in the background */
+#define GLEED_GOP_CACHE_DEFAULT_BUDGET (192 * 1024 * 1024)
+
+#define GLEED_NO_GOP 0xFFFFFFFFu
+
+typedef struct
+{
+    GleedVideoFrameYUV yuv;   /**< Copy of the decoded planes, pointing into data */
+    GleedVideoFrameYUV alpha; /**< Copy of the alpha luma plane, valid if has_alpha is set */
+    bool shown;               /**< Frame produced an image, hidden frames have no planes */
+    bool has_alpha;           /**< Frame came with a shown alpha frame */
+    Uint8 *data;              /**< Single allocation holding all planes of the frame */
+} GleedGOPFrame;
+
+typedef struct GleedCachedGOP
+{
+    Uint32 key_frame;            /**< Keyframe the group starts with */
+    Uint32 end;                  /**< One past the last frame of the group, i.e. the next keyframe */
+    GleedGOPFrame *frames;       /**< One entry per frame of the group */
+    size_t size;                 /**< Bytes of plane data held by the group */
+    struct GleedCachedGOP *next; /**< Next cached group, in no particular order */
+} GleedCachedGOP;
+
+typedef struct GleedGOPCache
+{
+    GleedMovie *movie;
+    SDL_Thread *thread;  /**< Decodes requested and prefetched groups */
+    SDL_Mutex *lock;     /**< Guards all fields below, except the ones owned by the thread */
+    SDL_Condition *cond; /**< Signalled when a request is made or a group is cached */
+
+    GleedCachedGOP *gops; /**< Cached groups */
+    size_t size;          /**< Bytes held by all cached groups */
+    size_t budget;        /**< Groups farthest from the scrubbed one are evicted beyond that */
+
+    Uint32 anchor_key;   /**< Group of the last scrubbed frame, never evicted */
+    Uint32 demand_key;   /**< Group the caller waits for, until the thread takes it; GLEED_NO_GOP if none */
+    Uint32 prefetch_key; /**< Group worth decoding while idle, GLEED_NO_GOP if none */
+    Uint32 busy_key;     /**< Group being decoded by the thread, GLEED_NO_GOP if idle */
+    Uint32 last_frame;   /**< Last scrubbed frame, tells which neighbour to prefetch */
+
+    bool quit;       /**< Thread should stop */
+    bool failed;     /**< Decoding the demanded group failed */
+    char error[256]; /**< Error message, valid if failed is set */
+
+    GleedVPXDecoder *decoder;        /**< Colour decoder, owned by the thread */
+    GleedVPXDecoder *alpha_decoder;  /**< Alpha decoder, created with the first frame carrying alpha */
+    GleedVideoDecodeQuality quality; /**< Quality all groups are decoded with, the cache is dropped when it changes */
+    Uint8 *data;                     /**< Packet buffer, owned by the thread */
+    Uint32 data_size;                /**< Capacity of the packet buffer */
+    Uint8 *alpha_data;               /**< Alpha packet buffer, owned by the thread */
+    Uint32 alpha_data_size;          /**< Capacity of the alpha packet buffer */
+} GleedGOPCache;
+
+static void GleedFreeCachedGOP(GleedCachedGOP *gop)
+{
+    const Uint32 count = gop->end - gop->key_frame;
+
+    for (Uint32 i = 0; i < count; i++)
+    {
+        SDL_free(gop->frames[i].data);
+    }
+
+    SDL_free(gop->frames);
+    SDL_free(gop);
+}
+
+static GleedCachedGOP *GleedFindCachedGOP(GleedGOPCache *cache, Uint32 key_frame)
+{
+    for (GleedCachedGOP *gop = cache->gops; gop; gop = gop->next)
+    {
+        if (gop->key_frame == key_frame)
+            return gop;
+    }
+
+    return NULL;
+}
+
+static Uint32 GleedGetGOPEnd(GleedMovie *movie, Uint32 key_frame)
+{
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    Uint32 end = key_frame + 1;
+
+    while (end < movie->total_frames && !frames[end].key_frame)
+    {
+        end++;
+    }
+
+    return end;
+}
+
+static int GleedGetPlaneRowSize(const GleedVideoFrameYUV *yuv, int plane)
+{
+    const int shift_x = plane > 0 ? yuv->chroma_shift_x : 0;
+
+    return ((yuv->w + shift_x) >> shift_x) * (yuv->bit_depth > 8 ? 2 : 1);
+}
+
+static int GleedGetPlaneRows(const GleedVideoFrameYUV *yuv, int plane)
+{
+    const int shift_y = plane > 0 ? yuv->chroma_shift_y : 0;
+
+    return (yuv->h + shift_y) >> shift_y;
+}
+
+/* Copies the plane tightly packed to out, pointing the destination frame at it; returns the first byte past it */
+static Uint8 *GleedCopyGOPPlane(const GleedVideoFrameYUV *src, GleedVideoFrameYUV *dst, int plane, Uint8 *out)
+{
+    const int row_size = GleedGetPlaneRowSize(src, plane);
+    const int rows = GleedGetPlaneRows(src, plane);
+
+    for (int y = 0; y < rows; y++)
+    {
+        SDL_memcpy(out + (size_t)y * row_size, src->planes[plane] + (size_t)y * src->pitches[plane], row_size);
+    }
+
+    dst->planes[plane] = out;
+    dst->pitches[plane] = row_size;
+
+    return out + (size_t)row_size * rows;
+}
+
+/* Decoder reuses its buffers with the next packet, so planes are copied; alpha only needs its luma */
+static bool GleedCopyGOPFrame(GleedGOPFrame *dst, const GleedVideoFrameYUV *yuv, const GleedVideoFrameYUV *alpha, size_t *size)
+{
+    size_t total = 0;
+
+    for (int plane = 0; plane < 3; plane++)
+    {
+        total += (size_t)GleedGetPlaneRowSize(yuv, plane) * GleedGetPlaneRows(yuv, plane);
+    }
+
+    if (alpha)
+    {
+        total += (size_t)GleedGetPlaneRowSize(alpha, 0) * GleedGetPlaneRows(alpha, 0);
+    }
+
+    dst->data = (Uint8 *)SDL_malloc(total);
+
+    if (!dst->data)
+    {
+        return GleedSetError("Failed to allocate memory for cached video frame");
+    }
+
+    Uint8 *out = dst->data;
+
+    dst->yuv = *yuv;
+
+    for (int plane = 0; plane < 3; plane++)
+    {
+        out = GleedCopyGOPPlane(yuv, &dst->yuv, plane, out);
+    }
+
+    if (alpha)
+    {
+        dst->alpha = *alpha;
+        dst->alpha.planes[1] = dst->alpha.planes[2] = NULL;
+
+        GleedCopyGOPPlane(alpha, &dst->alpha, 0, out);
+
+        dst->has_alpha = true;
+    }
+
+    dst->shown = true;
+    *size += total;
+
+    return true;
+}
+
+/* Called on the thread, unlocked; returns NULL with abandoned set if the caller demanded another group meanwhile */
+static GleedCachedGOP *GleedDecodeGOP(GleedGOPCache *cache, Uint32 key_frame, bool *abandoned)
+{
+    GleedMovie *movie = cache->movie;
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    *abandoned = false;
+
+    GleedCachedGOP *gop = (GleedCachedGOP *)SDL_calloc(1, sizeof(GleedCachedGOP));
+
+    if (!gop)
+    {
+        GleedSetError("Failed to allocate memory for cached group of pictures");
+        return NULL;
+    }
+
+    gop->key_frame = key_frame;
+    gop->end = GleedGetGOPEnd(movie, key_frame);
+    gop->frames = (GleedGOPFrame *)SDL_calloc(gop->end - key_frame, sizeof(GleedGOPFrame));
+
+    if (!gop->frames)
+    {
+        SDL_free(gop);
+        GleedSetError("Failed to allocate memory for cached group of pictures");
+        return NULL;
+    }
+
+    /* Every group starts at a keyframe, so the decoders only need their pending frames flushed */
+    GleedResetVPXDecoder(cache->decoder);
+
+    if (cache->alpha_decoder)
+    {
+        GleedResetVPXDecoder(cache->alpha_decoder);
+    }
+
+    for (Uint32 frame = key_frame; frame < gop->end; frame++)
+    {
+        SDL_LockMutex(cache->lock);
+        *abandoned = cache->demand_key != GLEED_NO_GOP && cache->demand_key != key_frame;
+        SDL_UnlockMutex(cache->lock);
+
+        if (*abandoned)
+            break;
+
+        const CachedMovieFrame *cached_frame = &frames[frame];
+
+        if (!GleedReadVideoPacket(movie, frame, &cache->data, &cache->data_size))
+            break;
+
+        GleedVideoFrameYUV yuv;
+        bool shown;
+
+        if (!GleedDecodeVPXPacket(cache->decoder, cache->data, cached_frame->size, frame, &yuv, &shown))
+            break;
+
+        GleedVideoFrameYUV alpha_yuv;
+        bool alpha_shown = false;
+
+        if (cached_frame->alpha_size > 0)
+        {
+            if (!cache->alpha_decoder)
+            {
+                cache->alpha_decoder = GleedCreateVPXDecoder(movie->video_codec);
+
+                if (!cache->alpha_decoder)
+                    break;
+
+                GleedSetVPXDecoderQuality(cache->alpha_decoder, cache->quality);
+            }
+
+            if (!GleedReadVideoAlphaPacket(movie, frame, &cache->alpha_data, &cache->alpha_data_size))
+                break;
+
+            if (!GleedDecodeVPXPacket(cache->alpha_decoder, cache->alpha_data, cached_frame->alpha_size, frame, &alpha_yuv, &alpha_shown))
+                break;
+        }
+
+        if (shown && !GleedCopyGOPFrame(&gop->frames[frame - key_frame], &yuv, alpha_shown ? &alpha_yuv : NULL, &gop->size))
+            break;
+
+        if (frame + 1 == gop->end)
+            return gop;
+    }
+
+    GleedFreeCachedGOP(gop);
+
+    return NULL;
+}
+
+/* Called with the lock held; groups farthest from the scrubbed one go first */
+static void GleedEvictGOPCache(GleedGOPCache *cache)
+{
+    while (cache->size > cache->budget)
+    {
+        GleedCachedGOP **farthest = NULL;
+        Uint32 farthest_distance = 0;
+
+        for (GleedCachedGOP **link = &cache->gops; *link; link = &(*link)->next)
+        {
+            const Uint32 key_frame = (*link)->key_frame;
+            const Uint32 distance = key_frame > cache->anchor_key ? key_frame - cache->anchor_key : cache->anchor_key - key_frame;
+
+            if (key_frame != cache->anchor_key && (!farthest || distance > farthest_distance))
+            {
+                farthest = link;
+                farthest_distance = distance;
+            }
+        }
+
+        if (!farthest)
+            break;
+
+        GleedCachedGOP *evicted = *farthest;
+        *farthest = evicted->next;
+
+        cache->size -= evicted->size;
+        GleedFreeCachedGOP(evicted);
+    }
+}
+
+static int GleedGOPCacheThread(void *data)
+{
+    GleedGOPCache *cache = (GleedGOPCache *)data;
+
+    SDL_LockMutex(cache->lock);
+
+    for (;;)
+    {
+        while (!cache->quit && cache->demand_key == GLEED_NO_GOP && cache->prefetch_key == GLEED_NO_GOP)
+        {
+            SDL_WaitCondition(cache->cond, cache->lock);
+        }
+
+        if (cache->quit)
+            break;
+
+        const bool demanded = cache->demand_key != GLEED_NO_GOP;
+        const Uint32 key_frame = demanded ? cache->demand_key : cache->prefetch_key;
+
+        /* Request is taken, the caller only waits for the group to show up in the cache */
+        if (demanded)
+        {
+            cache->demand_key = GLEED_NO_GOP;
+        }
+        else
+        {
+            cache->prefetch_key = GLEED_NO_GOP;
+        }
+
+        if (GleedFindCachedGOP(cache, key_frame))
+        {
+            SDL_BroadcastCondition(cache->cond);
+            continue;
+        }
+
+        cache->busy_key = key_frame;
+
+        SDL_UnlockMutex(cache->lock);
+
+        bool abandoned;
+        GleedCachedGOP *gop = GleedDecodeGOP(cache, key_frame, &abandoned);
+
+        SDL_LockMutex(cache->lock);
+
+        cache->busy_key = GLEED_NO_GOP;
+
+        if (gop)
+        {
+            gop->next = cache->gops;
+            cache->gops = gop;
+            cache->size += gop->size;
+
+            GleedEvictGOPCache(cache);
+        }
+        else if (demanded && !abandoned)
+        {
+            cache->failed = true;
+            SDL_strlcpy(cache->error, GleedGetError(), sizeof(cache->error));
+        }
+
+        SDL_BroadcastCondition(cache->cond);
+    }
+
+    SDL_UnlockMutex(cache->lock);
+
+    return 0;
+}
+
+static GleedGOPCache *GleedCreateGOPCache(GleedMovie *movie)
+{
+    GleedGOPCache *cache = (GleedGOPCache *)SDL_calloc(1, sizeof(GleedGOPCache));
+
+    if (!cache)
+    {
+        GleedSetError("Failed to allocate memory for GOP cache");
+        return NULL;
+    }
+
+    cache->movie = movie;
+    cache->budget = movie->gop_cache_budget > 0 ? movie->gop_cache_budget : GLEED_GOP_CACHE_DEFAULT_BUDGET;
+    cache->anchor_key = cache->demand_key = cache->prefetch_key = cache->busy_key = GLEED_NO_GOP;
+    cache->last_frame = movie->current_frame;
+    cache->quality = GleedGetVideoDecodeQuality(movie);
+
+    cache->lock = SDL_CreateMutex();
+    cache->cond = SDL_CreateCondition();
+    cache->decoder = GleedCreateVPXDecoder(movie->video_codec);
+
+    if (!cache->lock || !cache->cond || !cache->decoder)
+    {
+        if (!cache->lock || !cache->cond)
+            GleedSetError("Failed to create GOP cache lock: %s", SDL_GetError());
+
+        GleedDestroyVPXDecoder(cache->decoder);
+        SDL_DestroyCondition(cache->cond);
+        SDL_DestroyMutex(cache->lock);
+        SDL_free(cache);
+        return NULL;
+    }
+
+    GleedSetVPXDecoderQuality(cache->decoder, cache->quality);
+
+    cache->thread = SDL_CreateThread(GleedGOPCacheThread, "GleedGOPCache", cache);
+
+    if (!cache->thread)
+    {
+        GleedSetError("Failed to create GOP cache thread: %s", SDL_GetError());
+        GleedDestroyVPXDecoder(cache->decoder);
+        SDL_DestroyCondition(cache->cond);
+        SDL_DestroyMutex(cache->lock);
+        SDL_free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+void GleedDestroyGOPCache(GleedMovie *movie)
+{
+    GleedGOPCache *cache = movie->gop_cache;
+
+    if (!cache)
+        return;
+
+    SDL_LockMutex(cache->lock);
+    cache->quit = true;
+    SDL_BroadcastCondition(cache->cond);
+    SDL_UnlockMutex(cache->lock);
+
+    SDL_WaitThread(cache->thread, NULL);
+
+    while (cache->gops)
+    {
+        GleedCachedGOP *next = cache->gops->next;
+        GleedFreeCachedGOP(cache->gops);
+        cache->gops = next;
+    }
+
+    GleedDestroyVPXDecoder(cache->decoder);
+    GleedDestroyVPXDecoder(cache->alpha_decoder);
+    SDL_free(cache->data);
+    SDL_free(cache->alpha_data);
+    SDL_DestroyCondition(cache->cond);
+    SDL_DestroyMutex(cache->lock);
+    SDL_free(cache);
+
+    movie->gop_cache = NULL;
+}
+
+/* Called with the lock held, converts the cached image of the frame into the movie's frame surface */
+static bool GleedShowGOPFrame(GleedMovie *movie, const GleedGOPFrame *cached)
+{
+    movie->video_frame_shown = cached->shown;
+
+    if (!cached->shown)
+        return true;
+
+    SDL_Surface *target = GleedEnsureVideoFrameSurface(movie);
+
+    if (!target)
+        return false;
+
+    const Uint64 convert_start = SDL_GetTicksNS();
+
+    GleedConvertParams params;
+    params.crop = &movie->video_crop;
+    params.premultiply = movie->video_premultiplied_alpha;
+    params.fast = GleedGetVideoDecodeQuality(movie) >= GLEED_VIDEO_QUALITY_FAST;
+    params.mipmaps = movie->video_mipmaps;
+
+    GleedColorTransformTables *color = GleedAcquireVideoColorTransform(movie);
+    params.color = color;
+
+    const bool converted = GleedConvertYUVFrame(&cached->yuv, cached->has_alpha ? &cached->alpha : NULL, &params, target);
+
+    GleedReleaseColorTransform(color);
+
+    if (!converted)
+        return false;
+
+    movie->video_stats.converted_frames++;
+    movie->video_stats.convert_ns += SDL_GetTicksNS() - convert_start;
+
+    return true;
+}
+
+bool GleedScrubToFrame(GleedMovie *movie, Uint32 frame)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    if (!GleedCanPlaybackVideo(movie))
+        return GleedSetError("No tracks or playback data available");
+
+    if (movie->video_codec != GLEED_CODEC_TYPE_VP8 && movie->video_codec != GLEED_CODEC_TYPE_VP9)
+        return GleedSetError("Unsupported video codec, frame not decoded");
+
+    if (frame >= movie->total_frames)
+        return GleedSetError("Frame %u is out of range, movie has %u frames", frame, movie->total_frames);
+
+    if (!movie->gop_cache)
+    {
+        movie->gop_cache = GleedCreateGOPCache(movie);
+
+        if (!movie->gop_cache)
+            return false;
+    }
+
+    GleedGOPCache *cache = movie->gop_cache;
+
+    const Uint32 key_frame = GleedFindVideoKeyFrame(movie, frame);
+
+    SDL_LockMutex(cache->lock);
+
+    cache->anchor_key = key_frame;
+
+    GleedCachedGOP *gop = GleedFindCachedGOP(cache, key_frame);
+
+    if (!gop)
+    {
+        cache->demand_key = key_frame;
+        SDL_BroadcastCondition(cache->cond);
+
+        while (!(gop = GleedFindCachedGOP(cache, key_frame)) && !cache->failed)
+        {
+            SDL_WaitCondition(cache->cond, cache->lock);
+        }
+
+        cache->demand_key = GLEED_NO_GOP;
+
+        if (!gop)
+        {
+            cache->failed = false;
+            SDL_UnlockMutex(cache->lock);
+            return GleedSetError("%s", cache->error);
+        }
+    }
+
+    /* Image of whatever was decoded last is no longer current */
+    GleedReleaseFrameCacheEntry(movie->video_cache_hit);
+    movie->video_cache_hit = NULL;
+
+    if (!GleedShowGOPFrame(movie, &gop->frames[frame - key_frame]))
+    {
+        SDL_UnlockMutex(cache->lock);
+        return false;
+    }
+
+    /* Next group in the direction of scrubbing is decoded while this one is shown, so stepping into it does not stall */
+    const bool backwards = frame < cache->last_frame;
+    const Uint32 neighbour = backwards ? (key_frame > 0 ? GleedFindVideoKeyFrame(movie, key_frame - 1) : GLEED_NO_GOP)
+                                       : (gop->end < movie->total_frames ? gop->end : GLEED_NO_GOP);
+
+    if (neighbour != GLEED_NO_GOP && neighbour != cache->busy_key && !GleedFindCachedGOP(cache, neighbour))
+    {
+        cache->prefetch_key = neighbour;
+        SDL_BroadcastCondition(cache->cond);
+    }
+
+    cache->last_frame = frame;
+
+    SDL_UnlockMutex(cache->lock);
+
+    movie->current_frame = frame;
+
+    /* Audio follows, so playback may resume from the scrubbed frame */
+    if (GleedCanPlaybackAudio(movie))
+    {
+        const Uint64 timecode = movie->cached_frames[movie->current_video_track][frame].timecode;
+
+        movie->current_audio_frame = GleedFindFrameAtTimecode(movie, movie->current_audio_track, timecode);
+
+        GleedResetAudioDecoder(movie);
+    }
+
+    return true;
+}
+
+bool GleedStepFrame(GleedMovie *movie, int delta)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    const Sint64 frame = (Sint64)movie->current_frame + delta;
+
+    if (frame < 0 || frame >= (Sint64)movie->total_frames)
+        return GleedSetError("Cannot step %d frames from frame %u, movie has %u frames", delta, movie->current_frame, movie->total_frames);
+
+    return GleedScrubToFrame(movie, (Uint32)frame);
+}
+
+bool GleedSetGOPCacheBudget(GleedMovie *movie, size_t bytes)
+{
+    if (!movie)
+        return GleedSetError("Invalid movie");
+
+    movie->gop_cache_budget = bytes;
+
+    GleedGOPCache *cache = movie->gop_cache;
+
+    if (cache)
+    {
+        SDL_LockMutex(cache->lock);
+        cache->budget = bytes > 0 ? bytes : GLEED_GOP_CACHE_DEFAULT_BUDGET;
+        GleedEvictGOPCache(cache);
+        SDL_UnlockMutex(cache->lock);
+    }
+
+    return true;
+}
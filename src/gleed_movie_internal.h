@@ -22,15 +22,42 @@ extern "C"
      */
     typedef struct
     {
-        Uint64 timecode;   /**< Time code of frame, in Matroska ticks */
-        Uint32 mem_offset; /**< Offset in memory, IF frame data was stored continuously. This is crucial when you preload an audio stream for example  */
-        Uint32 offset;     /**< Offset of the frame in WebM file */
-        Uint32 size;       /**< Size of frame in WebM in bytes */
-        bool key_frame;    /**< Is given frame a keyframe; needed for seeking and maintaining codecs state */
+        Uint64 timecode;         /**< Time code of frame, in Matroska ticks */
+        Uint32 mem_offset;       /**< Offset in memory, IF frame data was stored continuously. This is crucial when you preload an audio stream for example  */
+        Uint32 offset;           /**< Offset of the frame in WebM file */
+        Uint32 size;             /**< Size of frame in WebM in bytes */
+        bool key_frame;          /**< Is given frame a keyframe; needed for seeking and maintaining codecs state */
+        bool hidden;             /**< Is given frame invisible (e.g. alt-ref), it must be decoded but never displayed */
+        Uint32 alpha_offset;     /**< Offset of the alpha payload (BlockAdditional) in WebM file */
+        Uint32 alpha_size;       /**< Size of the alpha payload, 0 if the frame has none */
     } CachedMovieFrame;
+    /**
+     * Flags controlling how much work is done when decoding a single video frame
+     */
+    typedef enum
+    {
+        GLEED_VIDEO_DECODE_ONLY = 0,               /**< Only update codec state, decoded image is not converted */
+        GLEED_VIDEO_DECODE_CONVERT = 1 << 0,       /**< Convert decoded image into target surface */
+        GLEED_VIDEO_DECODE_ALLOW_DROP = 1 << 1,    /**< Non-reference frames may be skipped without decoding */
+        GLEED_VIDEO_DECODE_CONVERT_LATER = 1 << 2, /**< Decoded image is kept for a following GleedConvertVideoFrameTo call */
+    } GleedVideoDecodeFlags;
+
+    /**
+     * Owner of everything parsed out of the container, which never changes after GleedOpenIO.
+     *
+     * Movie fields point into these allocations, clones of a movie share them and keep the index alive.
+     */
+    typedef struct GleedMovieIndex
+    {
+        SDL_AtomicInt refcount;                            /**< One reference per movie using the index */
+        CachedMovieFrame *cached_frames[MAX_GLEED_TRACKS]; /**< Frame tables of all tracks */
+        Uint8 *codec_private_data[MAX_GLEED_TRACKS];       /**< Codec private data of all tracks */
+    } GleedMovieIndex;
+
     typedef struct GleedMovie
     {
-        SDL_IOStream *io; /**< IO stream to read movie data */
+        SDL_IOStream *io;   /**< IO stream to read movie data */
+        SDL_Mutex *io_lock; /**< Guards io, as video frames may be read from a decoder thread while audio is read from the main one */
 
         Uint32 ntracks;                           /**< Number of tracks in the movie */
         GleedMovieTrack tracks[MAX_GLEED_TRACKS]; /**< Array of tracks */
@@ -39,14 +66,32 @@ extern "C"
         Uint32 capacity_cached_frames[MAX_GLEED_TRACKS];   /**< Capacity of cached frames for each track (vector-like allocation) */
         CachedMovieFrame *cached_frames[MAX_GLEED_TRACKS]; /**< Cached frames for each track */
 
-        Uint8 *encoded_video_frame;                /**< Current encoded video frame data */
-        Uint32 encoded_video_frame_size;           /**< Size of the encoded video frame data */
-        Uint8 *conversion_video_frame_buffer;      /**< Buffer for decoded video frame data, can be used by decoder to reduce allocations */
-        Uint32 conversion_video_frame_buffer_size; /**< Size of the buffer for decoded video frame data */
-        void *vpx_context;                         /**< VPX decoder context (both VP8 and VP9) */
-        SDL_PixelFormat video_pixel_format;        /**< Pixel format for the video track */
-        SDL_Surface *current_frame_surface;        /**< Current video frame surface, containing decoded frame pixels */
-        GleedMovieCodecType video_codec;           /**< Video codec type */
+        Uint8 *encoded_video_frame;                   /**< Current encoded video frame data */
+        Uint32 encoded_video_frame_size;              /**< Size of the encoded video frame data */
+        Uint8 *encoded_alpha_frame;                   /**< Alpha payload of the current video frame, read from the file along with it */
+        Uint32 encoded_alpha_frame_capacity;          /**< Capacity of encoded_alpha_frame */
+        void *vpx_context;                            /**< VPX decoder context (both VP8 and VP9) */
+        SDL_PixelFormat video_pixel_format;           /**< Pixel format of converted frames, video_output_format if set, else RGBA32 if the video track has alpha, RGB24 otherwise */
+        SDL_PixelFormat video_output_format;          /**< Format set with GleedSetVideoOutputFormat, SDL_PIXELFORMAT_UNKNOWN for the track default */
+        bool video_mipmaps;                           /**< Converted frames get a mip chain attached, see GleedSetVideoMipmapsEnabled */
+        struct GleedColorTransformTables *video_color; /**< Colour transform of converted frames, NULL for none; swapped under video_color_lock */
+        SDL_SpinLock video_color_lock;                /**< Guards video_color, decoder threads take references to it while converting */
+        bool video_frame_transformed;                 /**< Last converted frame went through video_color, so it is not shared through the frame cache */
+        bool video_premultiplied_alpha;               /**< Converted frames have colour premultiplied by alpha */
+        SDL_Surface *current_frame_surface;           /**< Current video frame surface, containing decoded frame pixels */
+        SDL_Rect video_crop;                          /**< Part of the video frame that is converted, in track pixels */
+        int video_output_w;                           /**< Width of converted frames, 0 to use the crop width */
+        int video_output_h;                           /**< Height of converted frames, 0 to use the crop height */
+        bool video_frame_shown;                       /**< Did the last decoded video frame produce a displayable image (hidden frames do not) */
+        GleedMovieVideoStats video_stats;             /**< Video decoding statistics */
+        SDL_AtomicInt video_quality;                  /**< GleedVideoDecodeQuality set by the caller, may change on another thread at any time */
+        GleedVideoDecodeQuality frame_quality;        /**< Snapshot of video_quality the current frame is decoded, converted and cached with */
+        bool video_cache_enabled;                     /**< Converted frames are shared with other instances through the frame cache */
+        struct GleedFrameCacheEntry *video_cache_hit; /**< Cached image of the current frame, when it was not decoded */
+        Uint64 fingerprint;                           /**< Hash of the parsed container layout, equal for every instance of the same file */
+        struct GleedGOPCache *gop_cache;              /**< Decoded groups of pictures for scrubbing, created by the first GleedScrubToFrame */
+        size_t gop_cache_budget;                      /**< Memory limit of gop_cache, 0 for the default */
+        GleedMovieCodecType video_codec;              /**< Video codec type */
 
         Uint8 *encoded_audio_frame;      /**< Current encoded audio frame data */
         Uint32 encoded_audio_frame_size; /**< Size of the encoded audio frame data */
@@ -66,10 +111,14 @@ extern "C"
 
         Uint64 timecode_scale; /**< Timecode scale from WebM file */
 
+        GleedMovieIndex *index; /**< Owner of the parsed tracks and frame tables, shared with clones */
+
         Uint32 last_frame_decode_ms; /**< Time in milliseconds spent to decode last frame */
+        Uint64 last_frame_decode_ns; /**< Same as last_frame_decode_ms, in nanoseconds */
 
-        Uint32 current_frame; /**< Current frame number */
-        Uint32 total_frames;  /**< Total number of frames in the movie */
+        Uint32 current_frame;      /**< Current frame number */
+        Uint32 total_frames;       /**< Total number of frames in the movie */
+        Uint32 decoder_next_frame; /**< Frame the video decoder state is valid for, i.e. one past the last decoded frame */
 
         Uint32 current_audio_frame; /**< Current audio frame number */
         Uint32 total_audio_frames;  /**< Total number of audio frames in the movie */
@@ -80,10 +129,36 @@ extern "C"
 
     extern bool GleedParseWebM(GleedMovie *movie);
 
-    extern bool GleedDecodeVPX(GleedMovie *movie);
+    extern bool GleedDecodeVPX(GleedMovie *movie, SDL_Surface *target, GleedVideoDecodeFlags flags);
+
+    extern bool GleedConvertVPX(GleedMovie *movie, SDL_Surface *target);
+
+    extern bool GleedIsVPXFrameDroppable(GleedMovieCodecType codec, const Uint8 *data, size_t size, const Uint8 *next_data, size_t next_size);
+
+    extern bool GleedIsVPXKeyFrame(GleedMovieCodecType codec, const Uint8 *data, size_t size);
+
+    extern void GleedResetVPX(GleedMovie *movie);
+
+    extern const GleedVideoFrameYUV *GleedAcquireVPXFrame(GleedMovie *movie);
 
     extern void GleedCloseVPX(GleedMovie *movie);
 
+    /**
+     * VPX decoder which is not tied to any movie decoding state, so several of them may run in parallel
+     */
+    typedef struct GleedVPXDecoder GleedVPXDecoder;
+
+    extern GleedVPXDecoder *GleedCreateVPXDecoder(GleedMovieCodecType codec);
+
+    /* Decoded planes stay valid until the next decode call or until the decoder is destroyed */
+    extern bool GleedDecodeVPXPacket(GleedVPXDecoder *decoder, const Uint8 *data, size_t size, Uint32 frame, GleedVideoFrameYUV *yuv, bool *shown);
+
+    extern void GleedSetVPXDecoderQuality(GleedVPXDecoder *decoder, GleedVideoDecodeQuality quality);
+
+    extern void GleedResetVPXDecoder(GleedVPXDecoder *decoder);
+
+    extern void GleedDestroyVPXDecoder(GleedVPXDecoder *decoder);
+
     typedef enum
     {
         GLEED_VORBIS_DECODE_DONE = 0,
@@ -94,30 +169,84 @@ extern "C"
 
     extern VorbisDecodeResult GleedDecode_Vorbis(GleedMovie *movie);
 
+    extern void GleedResetVorbis(GleedMovie *movie);
+
     extern void GleedCloseVorbis(GleedMovie *movie);
 
     extern bool GleedDecodeOpus(GleedMovie *movie);
 
+    extern void GleedResetOpus(GleedMovie *movie);
+
+    extern void GleedResetAudioDecoder(GleedMovie *movie);
+
     extern void GleedCloseOpus(GleedMovie *movie);
 
     extern bool GleedSetError(const char *fmt, ...);
 
-    extern void GleedAddCachedFrame(GleedMovie *movie, Uint32 track, Uint64 timecode, Uint32 offset, Uint32 size, bool key_frame);
+#define GLEED_HASH_INIT 0xCBF29CE484222325ull
+
+    /* FNV-1a, start with GLEED_HASH_INIT and chain calls to hash several buffers */
+    extern Uint64 GleedHashBytes(Uint64 hash, const void *data, size_t size);
+
+    extern void GleedAddCachedFrame(GleedMovie *movie, Uint32 track, Uint64 timecode, Uint32 offset, Uint32 size, bool key_frame, bool hidden);
+
+    extern bool GleedAddCachedFrameAlpha(GleedMovie *movie, Uint32 track, Uint32 frame, Uint64 offset, const Uint8 *data, Uint32 size);
 
     extern int GleedFindTrackByNumber(GleedMovie *movie, Uint32 track_number);
 
+    extern GleedMovieCodecType GleedGetTrackCodec(const GleedMovieTrack *track);
+
+    extern Uint32 GleedFindFrameAtTimecode(GleedMovie *movie, int track, Uint64 timecode);
+
+    extern Uint32 GleedFindVideoKeyFrame(GleedMovie *movie, Uint32 frame);
+
+    /* Brings the video decoder state up to the given frame, decoding from the last decoded frame or the keyframe before it */
+    extern bool GleedCatchUpVideoDecoder(GleedMovie *movie, Uint32 frame);
+
+    /* Stops the scrubbing decoder thread and frees the decoded groups of pictures, if there are any */
+    extern void GleedDestroyGOPCache(GleedMovie *movie);
+
+    /* Reads a video packet into a growing buffer, under the IO lock, so any thread may use it */
+    extern bool GleedReadVideoPacket(GleedMovie *movie, Uint32 frame, Uint8 **data, Uint32 *capacity);
+
+    extern bool GleedReadVideoAlphaPacket(GleedMovie *movie, Uint32 frame, Uint8 **data, Uint32 *capacity);
+
     extern bool GleedCanPlaybackVideo(GleedMovie *movie);
 
     extern bool GleedCanPlaybackAudio(GleedMovie *movie);
 
     extern GleedMovieTrack *GleedGetVideoTrack(GleedMovie *movie);
 
+    extern void GleedGetVideoOutputSize(GleedMovie *movie, int *w, int *h);
+
+    extern GleedVideoDecodeQuality GleedGetVideoDecodeQuality(GleedMovie *movie);
+
+    /* Movie's own frame surface, created with the output size on first use */
+    extern SDL_Surface *GleedEnsureVideoFrameSurface(GleedMovie *movie);
+
+    extern SDL_Surface *GleedCreateVideoFrameSurface(GleedMovie *movie, int w, int h);
+
     extern GleedMovieTrack *GleedGetAudioTrack(GleedMovie *movie);
 
     extern void *GleedReadEncodedAudioData(GleedMovie *movie, void *dest, int size);
 
     extern void GleedReadCurrentFrame(GleedMovie *movie, GleedMovieTrackType type);
 
+    extern bool GleedDecodeVideoFrameTo(GleedMovie *movie, SDL_Surface *target, GleedVideoDecodeFlags flags);
+
+    /* Converts the image of the last decoded frame, into the movie's frame surface if target is NULL */
+    extern bool GleedConvertVideoFrameTo(GleedMovie *movie, SDL_Surface *target);
+
+    /* Same as GleedConvertVideoFrameTo, into caller memory of the output size */
+    extern bool GleedConvertVideoFrameToPixels(GleedMovie *movie, void *pixels, int pitch, SDL_PixelFormat format);
+
+    /* Checks a caller buffer can hold converted frames of the output size */
+    extern bool GleedCheckVideoOutputBuffer(GleedMovie *movie, const void *pixels, int pitch, SDL_PixelFormat format);
+
+    extern bool GleedIsVideoFrameSuperseded(GleedMovie *movie, Uint64 time);
+
+    extern bool GleedUpdateTextureFromSurface(SDL_Surface *surface, SDL_Texture *texture);
+
     extern CachedMovieFrame *GleedGetCurrentCachedFrame(GleedMovie *movie, GleedMovieTrackType type);
 
     extern Uint64 GleedTimecodeToMilliseconds(GleedMovie *movie, Uint64 timecode);
@@ -126,6 +255,249 @@ extern "C"
 
     extern Uint64 GleedMillisecondsToTimecode(GleedMovie *movie, Uint64 ms);
 
+    /**
+     * Reusable, SIMD-aligned memory block for a decoded frame, owned by GleedFrameBufferPool
+     */
+    typedef struct GleedFrameBuffer
+    {
+        Uint8 *data;            /**< Buffer memory */
+        size_t size;            /**< Size of the buffer memory in bytes */
+        SDL_AtomicInt refcount; /**< Decoder and every acquired frame hold one reference each, buffer is free at 0 */
+    } GleedFrameBuffer;
+
+    /**
+     * Pool of frame buffers handed to the video decoder, so decoded frames live in memory we control
+     * and can be referenced without copying.
+     *
+     * Pool is reference counted itself, as acquired frames may outlive the decoder and the movie.
+     */
+    typedef struct GleedFrameBufferPool
+    {
+        SDL_Mutex *lock;             /**< Guards buffers array, reference counts are atomic */
+        GleedFrameBuffer **buffers;  /**< All buffers ever allocated by the pool */
+        int count;                   /**< Number of buffers */
+        int capacity;                /**< Capacity of buffers array */
+        size_t buffer_size;          /**< Preferred buffer size, estimated from the track dimensions */
+        SDL_AtomicInt refcount;      /**< Pool is freed when the last reference is released */
+    } GleedFrameBufferPool;
+
+    /**
+     * Acquired frame, public GleedVideoFrameYUV with the references keeping its planes alive
+     */
+    typedef struct
+    {
+        GleedVideoFrameYUV yuv;     /**< Public part, must stay the first member */
+        GleedFrameBuffer *buffer;   /**< Buffer holding the planes */
+        GleedFrameBufferPool *pool; /**< Pool the buffer belongs to */
+    } GleedVideoFrameRef;
+
+    extern GleedFrameBufferPool *GleedCreateFrameBufferPool(size_t buffer_size);
+
+    extern void GleedRetainFrameBufferPool(GleedFrameBufferPool *pool);
+
+    extern void GleedReleaseFrameBufferPool(GleedFrameBufferPool *pool);
+
+    extern GleedFrameBuffer *GleedGetFrameBuffer(GleedFrameBufferPool *pool, size_t min_size);
+
+    extern void GleedRetainFrameBuffer(GleedFrameBuffer *buffer);
+
+    extern void GleedReleaseFrameBuffer(GleedFrameBuffer *buffer);
+
+    /**
+     * Identity of a converted frame in the process-wide frame cache: which frame of which file, converted how
+     */
+    typedef struct
+    {
+        Uint64 fingerprint;              /**< GleedMovie fingerprint, equal for every instance of the same file */
+        Sint32 track;                    /**< Video track index */
+        Uint32 frame;                    /**< Frame index in the track */
+        SDL_Rect crop;                   /**< Crop the frame was converted with */
+        int w;                           /**< Width of the converted frame */
+        int h;                           /**< Height of the converted frame */
+        SDL_PixelFormat format;          /**< Pixel format of the converted frame */
+        bool premultiply;                /**< Colour premultiplied by alpha */
+        GleedVideoDecodeQuality quality; /**< Decode quality the frame was converted with */
+    } GleedFrameCacheKey;
+
+    /**
+     * Converted frame shared by all movie instances through the frame cache
+     */
+    typedef struct GleedFrameCacheEntry
+    {
+        GleedFrameCacheKey key;                 /**< Frame identity, zeroed before filling so it can be compared with memcmp */
+        SDL_Surface *surface;                   /**< Converted frame pixels */
+        size_t size;                            /**< Memory taken by the pixels */
+        SDL_AtomicInt refcount;                 /**< Cache holds one reference while the entry is in it, every user one more */
+        struct GleedFrameCacheEntry *hash_next; /**< Next entry in the same hash bucket */
+        struct GleedFrameCacheEntry *lru_prev;  /**< More recently used entry */
+        struct GleedFrameCacheEntry *lru_next;  /**< Less recently used entry */
+    } GleedFrameCacheEntry;
+
+    /* Returns a referenced entry, or NULL if the frame is not cached */
+    extern GleedFrameCacheEntry *GleedAcquireFrameCacheEntry(const GleedFrameCacheKey *key);
+
+    extern void GleedReleaseFrameCacheEntry(GleedFrameCacheEntry *entry);
+
+    /* Adds a copy of the surface, evicting least recently used frames to stay within the memory limit */
+    extern void GleedAddFrameCacheEntry(const GleedFrameCacheKey *key, const SDL_Surface *surface);
+
+    /**
+     * Kinds of decoder contexts kept in the decoder pool
+     */
+    typedef enum
+    {
+        GLEED_POOLED_DECODER_VPX = 0,    /**< VPXContext, keyed by codec type */
+        GLEED_POOLED_DECODER_OPUS = 1,   /**< Opus context, keyed by sample rate and channel count */
+        GLEED_POOLED_DECODER_VORBIS = 2, /**< Vorbis context, keyed by the hash of the track headers */
+    } GleedPooledDecoderType;
+
+    typedef void (*GleedDestroyPooledDecoder)(void *context);
+
+    /* Returns a parked context of the given kind and key, or NULL if there is none */
+    extern void *GleedTakePooledDecoder(GleedPooledDecoderType type, Uint64 key);
+
+    /* Parks a context that was reset by its movie, or destroys it right away if the pool is full */
+    extern void GleedParkPooledDecoder(GleedPooledDecoderType type, Uint64 key, void *context, GleedDestroyPooledDecoder destroy);
+
+    typedef struct GleedWorkerPool GleedWorkerPool;
+
+    /* Sets up the state of a worker, called before its first job; state is zeroed, cleanup runs even if this fails */
+    typedef bool (*GleedWorkerInit)(GleedWorkerPool *pool, void *worker);
+
+    typedef bool (*GleedWorkerJob)(GleedWorkerPool *pool, void *worker, int job);
+
+    typedef void (*GleedWorkerCleanup)(GleedWorkerPool *pool, void *worker);
+
+    /**
+     * Jobs spread over short-lived threads, the calling thread being one of them
+     */
+    struct GleedWorkerPool
+    {
+        const char *name;           /**< Name of the threads */
+        int max_threads;            /**< Upper bound of threads, including the calling one */
+        int job_count;              /**< Number of jobs */
+        size_t worker_size;         /**< Size of the state each worker keeps across its jobs */
+        GleedWorkerInit init;       /**< Optional, called lazily, a thread may come late and find nothing left to do */
+        GleedWorkerJob run;         /**< Runs one job, a failure stops the pool */
+        GleedWorkerCleanup cleanup; /**< Optional, frees the state of a worker */
+        void *userdata;
+
+        SDL_AtomicInt next_job; /**< Next job to be picked up by a worker */
+        SDL_AtomicInt stopped;  /**< Set by GleedStopWorkerPool or when a worker fails, no further jobs are picked up */
+        SDL_AtomicInt failed;   /**< Set by the first worker that fails */
+        char error[256];        /**< Error message of the failed worker */
+    };
+
+    /* Runs all jobs and returns once every worker is done, false with the error of the first failed job */
+    extern bool GleedRunWorkerPool(GleedWorkerPool *pool);
+
+    extern void GleedStopWorkerPool(GleedWorkerPool *pool);
+
+    extern bool GleedIsWorkerPoolStopped(GleedWorkerPool *pool);
+
+    /**
+     * GleedColorTransform prepared for the converter, shared read-only by every thread converting with it
+     */
+    typedef struct GleedColorTransformTables
+    {
+        SDL_AtomicInt refcount;   /**< Owner holds one reference, every conversion in flight one more */
+        bool has_matrix;          /**< Matrix stage is used, otherwise channels go straight to the lookup */
+        Sint32 matrix[3][3][256]; /**< Contribution of each input channel value to each output channel, 8 fractional bits */
+        Sint32 offset[3];         /**< Constant part of each output channel, rounding included */
+        Uint8 lut[3][256];        /**< Per-channel lookup with gamma and fade folded in, identity if neither is used */
+    } GleedColorTransformTables;
+
+    extern GleedColorTransformTables *GleedCompileColorTransform(const GleedColorTransform *transform);
+
+    extern void GleedReleaseColorTransform(GleedColorTransformTables *tables);
+
+    /* Returns a reference to the current transform of the movie, or NULL if it has none */
+    extern GleedColorTransformTables *GleedAcquireVideoColorTransform(GleedMovie *movie);
+
+    /* Makes movie use the transform of source, e.g. when a player switches between them */
+    extern void GleedShareVideoColorTransform(GleedMovie *movie, GleedMovie *source);
+
+    /**
+     * How a decoded frame is turned into output pixels
+     */
+    typedef struct
+    {
+        const SDL_Rect *crop;                   /**< Part of the frame to convert, NULL for the whole frame */
+        bool premultiply;                       /**< Premultiply colour by alpha, if the output has alpha */
+        bool fast;                              /**< Point sampled scaling and plain rounding instead of dithering */
+        bool mipmaps;                           /**< Also fill the mip levels attached to the target as alternate images, creating them if needed */
+        const GleedColorTransformTables *color; /**< Colour transform applied before packing, NULL for none */
+    } GleedConvertParams;
+
+    extern bool GleedIsVideoOutputFormatSupported(SDL_PixelFormat format);
+
+    /* Alpha is taken from the luma plane of a second frame, if given and the output format has alpha */
+    extern bool GleedConvertYUVFrame(const GleedVideoFrameYUV *src, const GleedVideoFrameYUV *alpha, const GleedConvertParams *params, SDL_Surface *dst);
+
+    /* Fills the mip levels of an already converted surface from its pixels, for frames that were not converted by us */
+    extern bool GleedGenerateSurfaceMipmaps(SDL_Surface *surface);
+
+    /**
+     * Single decoded and converted video frame, waiting in GleedVideoFrameQueue to be displayed
+     */
+    typedef struct
+    {
+        SDL_Surface *surface; /**< Converted frame pixels, owned by the queue */
+        Uint64 pts;           /**< Presentation time in milliseconds (in movie time) */
+        Uint32 frame;         /**< Index of the frame in the video track */
+        Uint64 decode_ns;     /**< Time the decoder thread spent decoding and converting the frame */
+    } GleedQueuedVideoFrame;
+
+    /**
+     * Bounded ring of decoded video frames, filled ahead of the playhead by a background decoder thread.
+     *
+     * While the queue exists, the decoder thread owns all video decoding state of the movie,
+     * so nothing else may decode or seek its video track.
+     */
+    typedef struct GleedVideoFrameQueue
+    {
+        GleedMovie *mov;      /**< Movie instance being decoded */
+        SDL_Thread *thread;   /**< Decoder thread */
+        SDL_Mutex *lock;      /**< Guards all fields below */
+        SDL_Condition *cond;  /**< Signalled when a frame was pushed or popped */
+
+        GleedQueuedVideoFrame *frames; /**< Ring of frames, each slot owns its own surface */
+        Uint32 capacity;               /**< Number of slots in the ring */
+        Uint32 head;                   /**< Index of the oldest queued frame */
+        Uint32 count;                  /**< Number of queued frames */
+        Uint64 playhead;               /**< Time of the last pop, frames superseded by then are not converted */
+
+        bool quit;       /**< Decoder thread should stop */
+        bool eof;        /**< Decoder thread has decoded all frames */
+        bool failed;     /**< Decoder thread has stopped on error */
+        char error[256]; /**< Error message of the decoder thread, valid if failed is set */
+
+        GleedMovieVideoStats stats; /**< Movie video stats as of the last frame the decoder thread finished */
+        Uint32 late_frames;         /**< Frames dropped by pops, added to the movie stats when the queue is destroyed */
+    } GleedVideoFrameQueue;
+
+    extern GleedVideoFrameQueue *GleedCreateVideoFrameQueue(GleedMovie *mov, Uint32 capacity);
+
+    extern void GleedDestroyVideoFrameQueue(GleedVideoFrameQueue *queue);
+
+    extern bool GleedPopVideoFrame(GleedVideoFrameQueue *queue, Uint64 time, SDL_Surface **surface, Uint64 *decode_ns, bool *popped);
+
+    extern void GleedGetVideoFrameQueueStats(GleedVideoFrameQueue *queue, GleedMovieVideoStats *stats);
+
+    extern bool GleedPeekVideoFrameTime(GleedVideoFrameQueue *queue, Uint64 *pts);
+
+    extern bool GleedIsVideoFrameQueueDrained(GleedVideoFrameQueue *queue);
+
+    /* Blocks until the decoder thread has queued a frame or stopped, returns false if it failed */
+    extern bool GleedWaitVideoFrameQueue(GleedVideoFrameQueue *queue);
+
+    /* Same content in another movie or another track, see GleedAddPlayerVariant */
+    typedef struct
+    {
+        GleedMovie *mov; /**< Movie of the variant, may be the same for several variants */
+        int video_track; /**< Video track of the movie this variant plays */
+    } GleedPlayerVariant;
+
     typedef struct GleedMoviePlayer
     {
         bool paused;         /**< Is player paused */
@@ -133,6 +505,8 @@ extern "C"
         bool video_playback; /**< Is video playback enabled */
         bool audio_playback; /**< Is audio playback enabled */
         GleedMovie *mov;     /**< Movie instance */
+        GleedMovie *owned_movie; /**< Movie opened by the player itself and freed with it, NULL if it belongs to the caller */
+        bool owned_movie_io;     /**< IO stream of owned_movie was opened by the player too, and is closed with it */
 
         Uint64 last_frame_at_ticks; /**< Last frame time in ticks, used for synchronization */
 
@@ -148,8 +522,37 @@ extern "C"
         int audio_output_samples_buffer_ms;   /**< Audio output frame size in ms (hardware-specific) */
 
         Uint64 next_video_frame_at;               /**< Time in milliseconds when next video frame should be played (in movie time) */
-        SDL_Surface *current_video_frame_surface; /**< Current video frame surface */
-        SDL_Texture *output_video_frame_texture;  /**< Output video frame texture, may be NULL */
+        SDL_Surface *current_video_frame_surface; /**< Current video frame surface, when frames are decoded ahead */
+        SDL_Texture *output_video_frame_texture;  /**< Output texture holding the current frame, may be NULL */
+
+        SDL_Texture *output_textures[GLEED_PLAYER_MAX_OUTPUT_TEXTURES]; /**< Ring of output textures, frames are written to them in turn */
+        int output_texture_count;                                     /**< Number of textures in the ring, 0 if texture output is disabled */
+        int next_output_texture;                                      /**< Ring index of the texture the next frame goes to */
+        bool owns_output_textures;                                    /**< Textures were created by the player and are destroyed with it */
+
+        void *output_pixels;           /**< Caller buffer frames are written to, NULL if buffer output is disabled */
+        int output_pitch;              /**< Row length of output_pixels in bytes */
+        SDL_PixelFormat output_format; /**< Pixel format of output_pixels */
+        int output_w;                  /**< Frame width output_pixels was set for */
+        int output_h;                  /**< Frame height output_pixels was set for */
+
+        Uint32 decode_ahead_frames;        /**< Capacity of the decode-ahead queue, 0 if decoding synchronously */
+        GleedVideoFrameQueue *video_queue; /**< Decode-ahead queue, NULL if decoding synchronously or not visible */
+
+        GleedPlayerVisibility visibility; /**< How much video work is done, see GleedSetPlayerVisibility */
+        bool video_frame_prepared;        /**< Frame before the current one was converted by GleedPreparePlayer, waiting to be shown */
+
+        Uint64 update_budget_ns;   /**< Longest time an update may spend decoding, 0 if unlimited */
+        Uint64 update_deadline_ns; /**< SDL_GetTicksNS value the running update stops decoding at */
+
+        GleedPlayerVariant variants[GLEED_PLAYER_MAX_VARIANTS]; /**< Registered variants, variants[0] is the movie the player was created with */
+        int variant_count;                                      /**< Number of registered variants, 0 if there are none */
+        int current_variant;                                    /**< Variant the player's movie and video track belong to */
+        int pending_variant;                                    /**< Variant to switch to at its next keyframe, -1 if none */
+        Uint64 pending_variant_after;                           /**< Playback time the switch was decided at, only later keyframes qualify */
+        Uint64 variant_budget_ns;                               /**< Frame cost the current variant has to stay under, 0 to use the frame duration */
+        Uint64 variant_cost_ns;                                 /**< Running average of decode and conversion time per frame of the current variant */
+        Uint32 variant_cost_samples;                            /**< Frames variant_cost_ns was averaged over since the last switch */
     } GleedMoviePlayer;
 
     extern void GleedAddAudioSamplesToPlayer(
@@ -10,8 +10,27 @@ typedef struct
     int pcm_buffer_size_per_channel;
 } MovieOpusContext;
 
+/* Opus decoder state only depends on the output rate and channel count */
+static Uint64 GleedGetOpusPoolKey(GleedMovie *movie)
+{
+    return ((Uint64)movie->audio_spec.freq << 32) | (Uint32)movie->audio_spec.channels;
+}
+
+static void GleedDestroyOpusContext(void *context)
+{
+    MovieOpusContext *ctx = (MovieOpusContext *)context;
+    opus_decoder_destroy(ctx->decoder);
+    SDL_free(ctx->pcm_buffer);
+    SDL_free(ctx);
+}
+
 bool GleedDecodeOpus(GleedMovie *movie)
 {
+    if (!movie->opus_context)
+    {
+        movie->opus_context = GleedTakePooledDecoder(GLEED_POOLED_DECODER_OPUS, GleedGetOpusPoolKey(movie));
+    }
+
     if (!movie->opus_context)
     {
         movie->opus_context = SDL_calloc(1, sizeof(MovieOpusContext));
@@ -77,13 +96,23 @@ bool GleedDecodeOpus(GleedMovie *movie)
     return true;
 }
 
+void GleedResetOpus(GleedMovie *movie)
+{
+    if (movie->opus_context)
+    {
+        MovieOpusContext *ctx = (MovieOpusContext *)movie->opus_context;
+        opus_decoder_ctl(ctx->decoder, OPUS_RESET_STATE);
+    }
+}
+
 void GleedCloseOpus(GleedMovie *movie)
 {
     if (movie->opus_context)
     {
         MovieOpusContext *ctx = (MovieOpusContext *)movie->opus_context;
-        opus_decoder_destroy(ctx->decoder);
-        SDL_free(movie->opus_context);
+        opus_decoder_ctl(ctx->decoder, OPUS_RESET_STATE);
+
+        GleedParkPooledDecoder(GLEED_POOLED_DECODER_OPUS, GleedGetOpusPoolKey(movie), ctx, GleedDestroyOpusContext);
         movie->opus_context = NULL;
     }
 }
\ No newline at end of file
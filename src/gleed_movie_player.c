@@ -2,11 +2,119 @@
 
 #define GLEED_PLAYER_SOUND_PRELOAD_MS 50
 
+/* Frames averaged before a variant is judged too slow, and before it is trusted to have headroom for a bigger one */
+#define GLEED_PLAYER_VARIANT_DOWN_SAMPLES 8
+#define GLEED_PLAYER_VARIANT_UP_SAMPLES 60
+
+static bool GleedPrerollPlayerAudio(GleedMovie *mov, Uint64 time_ms);
+
 static bool check_player(GleedMoviePlayer *player)
 {
     return player && player->mov;
 }
 
+/* Queue converts every frame it decodes, so it only runs while the player is visible */
+static bool GleedShouldPlayerDecodeAhead(GleedMoviePlayer *player)
+{
+    return player->decode_ahead_frames > 0 && player->video_playback && player->visibility == GLEED_PLAYER_VISIBLE;
+}
+
+/* Without a queue frames are decoded on the update thread, decode-ahead is turned off so the settings say so too */
+static bool GleedStartPlayerDecodeAhead(GleedMoviePlayer *player, GleedMovie *mov)
+{
+    player->video_queue = GleedCreateVideoFrameQueue(mov, player->decode_ahead_frames);
+
+    if (!player->video_queue)
+    {
+        player->decode_ahead_frames = 0;
+        return false;
+    }
+
+    return true;
+}
+
+static void GleedReleasePlayerOutputTextures(GleedMoviePlayer *player)
+{
+    if (player->owns_output_textures)
+    {
+        for (int i = 0; i < player->output_texture_count; i++)
+        {
+            SDL_DestroyTexture(player->output_textures[i]);
+        }
+    }
+
+    SDL_zeroa(player->output_textures);
+    player->output_texture_count = 0;
+    player->next_output_texture = 0;
+    player->owns_output_textures = false;
+    player->output_video_frame_texture = NULL;
+}
+
+/* Texture the next frame is written to; the one on screen is the last in the ring to be written again */
+static SDL_Texture *GleedGetNextPlayerOutputTexture(GleedMoviePlayer *player)
+{
+    return player->output_textures[player->next_output_texture];
+}
+
+static void GleedAdvancePlayerOutputTexture(GleedMoviePlayer *player)
+{
+    player->output_video_frame_texture = player->output_textures[player->next_output_texture];
+    player->next_output_texture = (player->next_output_texture + 1) % player->output_texture_count;
+}
+
+/* Buffer is only known to hold frames of the size it was set for, anything else would be written past its end */
+static bool GleedCheckPlayerOutputBuffer(GleedMoviePlayer *player, int w, int h)
+{
+    if (w == player->output_w && h == player->output_h)
+        return true;
+
+    player->output_pixels = NULL;
+
+    return GleedSetError("Video size changed from %dx%d to %dx%d, output buffer disabled",
+                         player->output_w, player->output_h, w, h);
+}
+
+/* Converts the frame just decoded straight into the output: locked texture memory, caller buffer, or the movie's frame surface */
+static bool GleedOutputPlayerVideoFrame(GleedMoviePlayer *player)
+{
+    if (player->output_pixels)
+    {
+        int w, h;
+        GleedGetVideoOutputSize(player->mov, &w, &h);
+
+        if (!GleedCheckPlayerOutputBuffer(player, w, h))
+            return false;
+
+        return GleedConvertVideoFrameToPixels(player->mov, player->output_pixels, player->output_pitch, player->output_format);
+    }
+
+    if (player->output_texture_count == 0)
+    {
+        return GleedConvertVideoFrameTo(player->mov, NULL);
+    }
+
+    SDL_Texture *texture = GleedGetNextPlayerOutputTexture(player);
+    SDL_Surface *target;
+
+    if (!SDL_LockTextureToSurface(texture, NULL, &target))
+    {
+        return GleedSetError("Failed to lock output texture: %s", SDL_GetError());
+    }
+
+    const bool converted = GleedConvertVideoFrameTo(player->mov, target);
+
+    SDL_UnlockTexture(texture);
+
+    if (!converted)
+    {
+        return false;
+    }
+
+    GleedAdvancePlayerOutputTexture(player);
+
+    return true;
+}
+
 GleedMoviePlayer *GleedCreatePlayer(GleedMovie *mov)
 {
     if (!mov)
@@ -36,7 +144,19 @@ GleedMoviePlayer *GleedCreatePlayerFromPath(const char *path)
         return NULL;
     }
 
-    return GleedCreatePlayer(mov);
+    GleedMoviePlayer *player = GleedCreatePlayer(mov);
+
+    if (!player)
+    {
+        GleedFreeMovie(mov, true);
+        return NULL;
+    }
+
+    /* Nobody else has the movie, so it goes with the player, along with the file stream opened for it */
+    player->owned_movie = mov;
+    player->owned_movie_io = true;
+
+    return player;
 }
 
 GleedMoviePlayer *GleedCreatePlayerFromIO(SDL_IOStream *io)
@@ -48,7 +168,18 @@ GleedMoviePlayer *GleedCreatePlayerFromIO(SDL_IOStream *io)
         return NULL;
     }
 
-    return GleedCreatePlayer(mov);
+    GleedMoviePlayer *player = GleedCreatePlayer(mov);
+
+    if (!player)
+    {
+        GleedFreeMovie(mov, false);
+        return NULL;
+    }
+
+    /* Stream stays with the caller, only the movie opened on it is ours */
+    player->owned_movie = mov;
+
+    return player;
 }
 
 void GleedSetPlayerMovie(GleedMoviePlayer *player, GleedMovie *mov)
@@ -56,7 +187,19 @@ void GleedSetPlayerMovie(GleedMoviePlayer *player, GleedMovie *mov)
     if (!player || !mov)
         return;
 
+    /* Decoder thread must not touch the movie while we rewind it */
+    if (player->video_queue)
+    {
+        GleedDestroyVideoFrameQueue(player->video_queue);
+        player->video_queue = NULL;
+    }
+
     player->mov = mov;
+    player->variant_count = 0;
+    player->current_variant = 0;
+    player->pending_variant = -1;
+    player->variant_cost_samples = 0;
+    player->video_frame_prepared = false;
     player->current_time = 0;
     player->next_video_frame_at = 0;
     player->next_audio_frame_at = 0;
@@ -80,6 +223,11 @@ void GleedSetPlayerMovie(GleedMoviePlayer *player, GleedMovie *mov)
     {
         player->next_video_frame_at = GleedMatroskaTicksToMilliseconds(player->mov, video_track->codec_delay);
     }
+
+    if (GleedShouldPlayerDecodeAhead(player))
+    {
+        GleedStartPlayerDecodeAhead(player, player->mov);
+    }
 }
 
 void GleedFreePlayer(GleedMoviePlayer *player)
@@ -87,6 +235,8 @@ void GleedFreePlayer(GleedMoviePlayer *player)
     if (!player)
         return;
 
+    GleedDestroyVideoFrameQueue(player->video_queue);
+
     if (player->audio_buffer)
         SDL_free(player->audio_buffer);
 
@@ -100,233 +250,723 @@ void GleedFreePlayer(GleedMoviePlayer *player)
         SDL_DestroySurface(player->current_video_frame_surface);
     }
 
+    GleedReleasePlayerOutputTextures(player);
+
+    if (player->owned_movie)
+    {
+        GleedFreeMovie(player->owned_movie, player->owned_movie_io);
+    }
+
     SDL_free(player);
 }
 
-GleedMoviePlayerUpdateResult GleedUpdatePlayer(GleedMoviePlayer *player, int time_delta_ms)
+/* Budget is only checked between frames, so every update still decodes at least one of each */
+static bool GleedIsPlayerUpdateOverBudget(GleedMoviePlayer *player)
 {
-    if (!check_player(player))
-        return GLEED_PLAYER_UPDATE_NONE;
-
-    /*0 is treated as no time has passed*/
-    if (time_delta_ms == 0)
-        return GLEED_PLAYER_UPDATE_NONE;
-
-    if (player->paused || player->finished)
-        return GLEED_PLAYER_UPDATE_NONE;
-
-    GleedMoviePlayerUpdateResult result = GLEED_PLAYER_UPDATE_NONE;
-
-    /* Decide how much time passed since last update based on second argument*/
-    const Uint64 time_passed = time_delta_ms < 0 ? SDL_GetTicks() - player->last_frame_at_ticks : time_delta_ms;
+    return player->update_budget_ns > 0 && SDL_GetTicksNS() >= player->update_deadline_ns;
+}
 
-    player->current_time += time_passed;
+/*
+    A player that fell behind doesn't have to decode frames the playhead is past a keyframe of -
+    the decoder restarts from the last passed keyframe, and everything before it is dropped.
+*/
+static void GleedSkipPlayerToDueKeyFrame(GleedMoviePlayer *player)
+{
+    GleedMovie *mov = player->mov;
 
-    /*
-        Intuitively, we should record that at end of update,
-        but decoding can take quite a lot of time,
-        so the next update must account for it too
-    */
-    player->last_frame_at_ticks = SDL_GetTicks();
+    const Uint32 due_frame = GleedFindFrameAtTimecode(mov, mov->current_video_track, GleedMillisecondsToTimecode(mov, player->current_time));
+    const Uint32 key_frame = GleedFindVideoKeyFrame(mov, due_frame);
 
-    if (player->video_playback && GleedCanPlaybackVideo(player->mov) && player->current_time >= player->next_video_frame_at)
+    if (key_frame > mov->current_frame)
     {
-        CachedMovieFrame *next_frame_to_play = GleedGetCurrentCachedFrame(
-            player->mov, GLEED_TRACK_TYPE_VIDEO);
+        mov->current_frame = key_frame;
+    }
+}
 
-        /*
-            This function does not account for seeks, so we decode EACH frame until we reach the current time
-            assuming that really given time has passed since last update.
+/* Only frames decoded for display are sampled, so catching up after a seek does not trigger a switch */
+static void GleedSamplePlayerVariantCost(GleedMoviePlayer *player, Uint64 cost_ns)
+{
+    if (player->variant_count < 2)
+        return;
 
-            Moreover, for some reasons quite a few .webm files I have tested do not have
-            keyframes set correctly, and even seeking back to them before decoding does not help.
+    if (player->variant_cost_samples == 0)
+    {
+        player->variant_cost_ns = cost_ns;
+    }
+    else
+    {
+        player->variant_cost_ns = player->variant_cost_ns - player->variant_cost_ns / 8 + cost_ns / 8;
+    }
 
-            This probably SHOULD be optimized, but I am not quite sure how for now.
-        */
-        while (GleedHasNextVideoFrame(player->mov) && next_frame_to_play && GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode) <= player->current_time)
-        {
-            if (!GleedDecodeVideoFrame(player->mov))
-            {
-                return GLEED_PLAYER_UPDATE_ERROR;
-            }
-            GleedNextVideoFrame(player->mov);
-            next_frame_to_play = GleedGetCurrentCachedFrame(
-                player->mov, GLEED_TRACK_TYPE_VIDEO);
-        }
+    player->variant_cost_samples++;
+}
 
-        /* Either create a surface or just blit it*/
-        if (!player->current_video_frame_surface)
-        {
-            player->current_video_frame_surface = SDL_DuplicateSurface(
-                (SDL_Surface *)GleedGetVideoFrameSurface(player->mov));
-        }
-        else
-        {
-            SDL_BlitSurface(
-                (SDL_Surface *)GleedGetVideoFrameSurface(player->mov),
-                NULL,
-                player->current_video_frame_surface,
-                NULL);
-        }
+static Uint64 GleedGetPlayerVariantBudget(GleedMoviePlayer *player)
+{
+    if (player->variant_budget_ns > 0)
+        return player->variant_budget_ns;
 
-        /* If user set a target texture, update it's contents*/
-        if (player->output_video_frame_texture)
-        {
-            GleedUpdatePlaybackTexture(
-                player->mov,
-                player->output_video_frame_texture);
-        }
+    GleedMovie *mov = player->mov;
+    const GleedMovieTrack *video_track = GleedGetVideoTrack(mov);
 
-        if (next_frame_to_play)
-        {
-            player->next_video_frame_at = GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode);
-        }
+    if (video_track->video_frame_rate > 0)
+        return (Uint64)(SDL_NS_PER_SECOND / video_track->video_frame_rate);
 
-        result |= GLEED_PLAYER_UPDATE_VIDEO;
+    /* Frame rate is optional in WebM, the average frame duration does just as well */
+    if (mov->total_frames > 1)
+    {
+        const CachedMovieFrame *last_frame = &mov->cached_frames[mov->current_video_track][mov->total_frames - 1];
 
-        /* Currently video is used as determining factor if movie has ended */
-        if (!GleedHasNextVideoFrame(player->mov))
-        {
-            player->finished = true;
-        }
+        return SDL_MS_TO_NS(GleedTimecodeToMilliseconds(mov, last_frame->timecode)) / (mov->total_frames - 1);
     }
 
-    /*
-       Only advance audio if we
-       1) have it enabled
-       2) have audio track
-       3) it's time to play next frame
-   */
-    if (player->audio_playback && GleedCanPlaybackAudio(player->mov) && player->current_time >= player->next_audio_frame_at)
-    {
-        /* Audio output is much more sensitive to delays or interruptions, so we load a bit more samples */
-        const Uint64 preload_time = player->current_time + GLEED_PLAYER_SOUND_PRELOAD_MS;
-
-        CachedMovieFrame *next_frame_to_play = GleedGetCurrentCachedFrame(
-            player->mov, GLEED_TRACK_TYPE_AUDIO);
+    return SDL_NS_PER_SECOND / 30;
+}
 
-        /*
-            This function does not account for seeks, so we decode EACH frame until we reach the current time
-            assuming that really given time has passed since last update
-        */
-        while (GleedHasNextAudioFrame(player->mov) && GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode) < preload_time)
-        {
-            /*TODO: provide any recovery from such errors? maybe reset codec state */
-            if (!GleedDecodeAudioFrame(player->mov))
-            {
-                return GLEED_PLAYER_UPDATE_ERROR;
-            }
+static Uint64 GleedGetPlayerVariantPixels(GleedMoviePlayer *player, int variant)
+{
+    const GleedMovieTrack *track = &player->variants[variant].mov->tracks[player->variants[variant].video_track];
 
-            int samples_count;
+    return (Uint64)track->video_width * track->video_height;
+}
 
-            const GleedMovieAudioSample *samples = GleedGetAudioSamples(player->mov, NULL, &samples_count);
+/* Variant with the most pixels below (cheaper) or the fewest above (more expensive) the current one, -1 if there is none */
+static int GleedFindPlayerVariant(GleedMoviePlayer *player, bool cheaper)
+{
+    const Uint64 current_pixels = GleedGetPlayerVariantPixels(player, player->current_variant);
 
-            if (samples_count > 0)
-            {
-                GleedAddAudioSamplesToPlayer(player, samples, samples_count);
+    int found = -1;
+    Uint64 found_pixels = 0;
 
-                /* If output is set up, add samples to stream right away and forget about them*/
-                if (player->output_audio_stream)
-                {
-                    SDL_PutAudioStreamData(player->output_audio_stream, samples, samples_count * sizeof(GleedMovieAudioSample));
-                    player->audio_buffer_count = 0;
-                }
-            }
+    for (int i = 0; i < player->variant_count; i++)
+    {
+        const Uint64 pixels = GleedGetPlayerVariantPixels(player, i);
 
-            GleedNextAudioFrame(player->mov);
-            next_frame_to_play = GleedGetCurrentCachedFrame(
-                player->mov, GLEED_TRACK_TYPE_AUDIO);
-        }
+        if (cheaper ? pixels >= current_pixels : pixels <= current_pixels)
+            continue;
 
-        /* We will play next frame only after this timecode*/
-        if (next_frame_to_play)
+        if (found < 0 || (cheaper ? pixels > found_pixels : pixels < found_pixels))
         {
-            player->next_audio_frame_at = GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode);
+            found = i;
+            found_pixels = pixels;
         }
-
-        result |= GLEED_PLAYER_UPDATE_AUDIO;
     }
 
-    return result;
+    return found;
 }
 
-void GleedAddAudioSamplesToPlayer(
-    GleedMoviePlayer *player,
-    const GleedMovieAudioSample *samples,
-    int count)
+/* Last keyframe of the variant's track at or before the given playback time */
+static Uint32 GleedFindPlayerVariantKeyFrame(GleedMoviePlayer *player, int variant, Uint64 time_ms)
 {
-    if (!check_player(player))
-        return;
+    GleedMovie *mov = player->variants[variant].mov;
+    const int track = player->variants[variant].video_track;
 
-    if (!samples || count <= 0)
-        return;
+    const CachedMovieFrame *frames = mov->cached_frames[track];
 
-    if (!player->audio_buffer)
-    {
-        /*Allocate a buffer for at least hardware-provided samples count + plus amount of samples for 1 second at given frequency */
-        player->audio_buffer_capacity = player->mov->audio_spec.freq * player->mov->audio_spec.channels + player->audio_output_samples_buffer_size;
-        player->audio_buffer = (GleedMovieAudioSample *)SDL_calloc(player->audio_buffer_capacity, sizeof(GleedMovieAudioSample));
+    Uint32 frame = GleedFindFrameAtTimecode(mov, track, GleedMillisecondsToTimecode(mov, time_ms));
 
-        if (!player->audio_buffer)
-        {
-            GleedSetError("Failed to allocate memory for audio buffer");
-            return;
-        }
+    while (frame > 0 && !frames[frame].key_frame)
+    {
+        frame--;
     }
 
-    if (player->audio_buffer_count + count > player->audio_buffer_capacity)
+    return frame;
+}
+
+/* Brings a variant movie to the output settings of the one playing and positions it on the keyframe */
+static bool GleedPreparePlayerVariantMovie(GleedMovie *mov, int video_track, Uint32 key_frame, GleedMovie *old_mov, int output_w, int output_h)
+{
+    if (mov->current_video_track != video_track)
     {
-        /* Rollback to start of buffer and start overwriting, user should've read them at this point */
-        player->audio_buffer_count = 0;
+        GleedSelectTrack(mov, GLEED_TRACK_TYPE_VIDEO, video_track);
     }
 
-    /* Copy the samples manually */
-    for (int s = 0; s < count; s++)
+    if (!GleedSetVideoOutputSize(mov, output_w, output_h) ||
+        !GleedSetVideoOutputFormat(mov, old_mov->video_output_format) ||
+        !GleedSetVideoDecodeQuality(mov, GleedGetVideoDecodeQuality(old_mov)) ||
+        !GleedSetVideoPremultipliedAlpha(mov, old_mov->video_premultiplied_alpha))
     {
-        player->audio_buffer[player->audio_buffer_count + s] = samples[s];
+        return false;
     }
 
-    player->audio_buffer_count += count;
+    GleedShareVideoColorTransform(mov, old_mov);
+
+    mov->current_frame = key_frame;
+    mov->decoder_next_frame = mov->total_frames;
+
+    return true;
 }
 
-bool GleedSetPlayerAudioOutput(GleedMoviePlayer *player, SDL_AudioDeviceID dev)
+/*
+    Moves playback over to another variant, starting from its keyframe. Timeline is kept as is,
+    converted frames keep the size of the previous variant, so whatever they are written to stays valid.
+
+    A variant in another movie is set up completely while the old one keeps playing, and only then replaces it,
+    so on failure the player carries on with the old variant. Tracks of the same movie share its decoding state,
+    so the decoder thread has to stop first, and a failed switch puts the old track back.
+*/
+static bool GleedSwitchPlayerVariant(GleedMoviePlayer *player, int variant, Uint32 key_frame)
 {
-    if (!check_player(player))
-        return SDL_SetError("Invalid player");
+    GleedMovie *old_mov = player->mov;
+    GleedMovie *mov = player->variants[variant].mov;
+    const int video_track = player->variants[variant].video_track;
 
-    if (dev == SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK)
-    {
-        return SDL_SetError("Audio output device must be already opened or 0 to disable");
-    }
+    int output_w, output_h;
+    GleedGetVideoOutputSize(old_mov, &output_w, &output_h);
 
-    if (!GleedCanPlaybackAudio(player->mov))
-    {
-        return GleedSetError("No audio track selected");
-    }
+    /* Only needed to roll back a switch between tracks of the same movie */
+    const int old_video_track = old_mov->current_video_track;
+    const SDL_Rect old_crop = old_mov->video_crop;
+    const int old_output_w = old_mov->video_output_w;
+    const int old_output_h = old_mov->video_output_h;
 
-    if (player->output_audio_stream)
+    /* Decoder thread must not touch the movie while we reposition it */
+    if (mov == old_mov && player->video_queue)
     {
-        SDL_DestroyAudioStream(player->output_audio_stream);
-        player->output_audio_stream = NULL;
-        player->bound_audio_device = 0;
+        GleedDestroyVideoFrameQueue(player->video_queue);
+        player->video_queue = NULL;
     }
 
-    /* If zero was provided for device id - user wants to stop audio output */
-    if (!dev)
-    {
-        return true;
-    }
+    const Uint32 old_frame = old_mov->current_frame;
 
-    SDL_AudioSpec dst_audio_spec;
-    if (!SDL_GetAudioDeviceFormat(dev, &dst_audio_spec, &player->audio_output_samples_buffer_size))
+    bool prepared = GleedPreparePlayerVariantMovie(mov, video_track, key_frame, old_mov, output_w, output_h);
+
+    /* Audio picks up in the new movie right where the old one stopped, samples already queued play on */
+    if (prepared && mov != old_mov && player->audio_playback && GleedCanPlaybackAudio(mov))
     {
-        return GleedSetError("Failed to get audio device format: %s", SDL_GetError());
+        if (!GleedHasNextAudioFrame(old_mov))
+        {
+            mov->current_audio_frame = mov->total_audio_frames;
+        }
+        else
+        {
+            prepared = GleedPrerollPlayerAudio(mov, player->next_audio_frame_at);
+        }
     }
 
-    /* 1024 is the reasonable default?*/
-    if (!player->audio_output_samples_buffer_size)
+    GleedVideoFrameQueue *video_queue = NULL;
+
+    if (prepared && GleedShouldPlayerDecodeAhead(player))
     {
-        player->audio_output_samples_buffer_size = 1024;
+        video_queue = GleedCreateVideoFrameQueue(mov, player->decode_ahead_frames);
+        prepared = video_queue != NULL;
+    }
+
+    if (!prepared)
+    {
+        if (mov == old_mov)
+        {
+            /* Frames the stopped decoder thread had queued are lost, decoding resumes past them */
+            GleedSelectTrack(mov, GLEED_TRACK_TYPE_VIDEO, old_video_track);
+            GleedSetVideoCrop(mov, &old_crop);
+            GleedSetVideoOutputSize(mov, old_output_w, old_output_h);
+
+            mov->current_frame = old_frame;
+
+            if (GleedShouldPlayerDecodeAhead(player))
+            {
+                GleedStartPlayerDecodeAhead(player, mov);
+            }
+        }
+
+        return false;
+    }
+
+    /* Everything is in place, the old variant can go */
+    GleedDestroyVideoFrameQueue(player->video_queue);
+    player->video_queue = video_queue;
+
+    player->mov = mov;
+    player->current_variant = variant;
+    player->pending_variant = -1;
+    player->variant_cost_samples = 0;
+    player->next_video_frame_at = GleedTimecodeToMilliseconds(mov, mov->cached_frames[video_track][key_frame].timecode);
+
+    return true;
+}
+
+/* Picks the variant the measured frame cost calls for, and switches to it once the playhead passes one of its keyframes */
+static bool GleedAdaptPlayerVariant(GleedMoviePlayer *player)
+{
+    if (player->variant_count < 2 || player->video_frame_prepared)
+        return true;
+
+    if (player->pending_variant < 0)
+    {
+        const Uint64 budget_ns = GleedGetPlayerVariantBudget(player);
+
+        if (player->variant_cost_samples >= GLEED_PLAYER_VARIANT_DOWN_SAMPLES && player->variant_cost_ns > budget_ns)
+        {
+            player->pending_variant = GleedFindPlayerVariant(player, true);
+        }
+        else if (player->variant_cost_samples >= GLEED_PLAYER_VARIANT_UP_SAMPLES)
+        {
+            const int bigger = GleedFindPlayerVariant(player, false);
+
+            /* Cost grows about with the pixel count; a quarter of the budget is left spare, so we don't bounce right back */
+            if (bigger >= 0 &&
+                player->variant_cost_ns * GleedGetPlayerVariantPixels(player, bigger) <
+                    budget_ns / 4 * 3 * GleedGetPlayerVariantPixels(player, player->current_variant))
+            {
+                player->pending_variant = bigger;
+            }
+        }
+
+        if (player->pending_variant < 0)
+            return true;
+
+        player->pending_variant_after = player->current_time;
+    }
+
+    const Uint32 key_frame = GleedFindPlayerVariantKeyFrame(player, player->pending_variant, player->current_time);
+
+    const GleedPlayerVariant *variant = &player->variants[player->pending_variant];
+    const Uint64 key_frame_at = GleedTimecodeToMilliseconds(variant->mov, variant->mov->cached_frames[variant->video_track][key_frame].timecode);
+
+    /* Switching at an older keyframe would mean decoding frames that were shown already */
+    if (key_frame_at < player->pending_variant_after)
+        return true;
+
+    return GleedSwitchPlayerVariant(player, player->pending_variant, key_frame);
+}
+
+/* Video update when frames are decoded ahead by the decoder thread: only pop the one due for display */
+static GleedMoviePlayerUpdateResult GleedUpdatePlayerQueuedVideo(GleedMoviePlayer *player)
+{
+    GleedMoviePlayerUpdateResult result = GLEED_PLAYER_UPDATE_NONE;
+
+    bool popped = false;
+    Uint64 decode_ns = 0;
+
+    if (!GleedPopVideoFrame(player->video_queue, player->current_time, &player->current_video_frame_surface, &decode_ns, &popped))
+    {
+        return GLEED_PLAYER_UPDATE_ERROR;
+    }
+
+    if (popped)
+    {
+        GleedSamplePlayerVariantCost(player, decode_ns);
+
+        /* Decoder thread can't touch textures, so the popped frame is uploaded with a single copy */
+        if (player->output_texture_count > 0)
+        {
+            if (!GleedUpdateTextureFromSurface(player->current_video_frame_surface, GleedGetNextPlayerOutputTexture(player)))
+            {
+                return GLEED_PLAYER_UPDATE_ERROR;
+            }
+
+            GleedAdvancePlayerOutputTexture(player);
+        }
+        else if (player->output_pixels)
+        {
+            const SDL_Surface *surface = player->current_video_frame_surface;
+
+            if (!GleedCheckPlayerOutputBuffer(player, surface->w, surface->h))
+            {
+                return GLEED_PLAYER_UPDATE_ERROR;
+            }
+
+            if (!SDL_ConvertPixels(surface->w, surface->h, surface->format, surface->pixels, surface->pitch,
+                                   player->output_format, player->output_pixels, player->output_pitch))
+            {
+                GleedSetError("Failed to copy video frame to output buffer: %s", SDL_GetError());
+                return GLEED_PLAYER_UPDATE_ERROR;
+            }
+        }
+
+        result |= GLEED_PLAYER_UPDATE_VIDEO;
+    }
+
+    Uint64 next_frame_at;
+
+    /*
+        If the queue is empty but not drained, decoder thread is running behind -
+        we keep next_video_frame_at in the past, so the next update polls the queue again.
+    */
+    if (GleedPeekVideoFrameTime(player->video_queue, &next_frame_at))
+    {
+        player->next_video_frame_at = next_frame_at;
+    }
+    else if (GleedIsVideoFrameQueueDrained(player->video_queue))
+    {
+        player->finished = true;
+    }
+
+    return result;
+}
+
+/*
+    Video update of a player nobody looks at: the cursor follows the playhead, frames are never converted.
+    Frame on screen is left undecoded, so it is the first one decoded and shown once the player is visible again.
+*/
+static GleedMoviePlayerUpdateResult GleedUpdatePlayerHiddenVideo(GleedMoviePlayer *player)
+{
+    GleedMovie *mov = player->mov;
+
+    GleedMoviePlayerUpdateResult result = GLEED_PLAYER_UPDATE_NONE;
+
+    if (player->update_budget_ns > 0 && player->visibility == GLEED_PLAYER_HIDDEN)
+    {
+        GleedSkipPlayerToDueKeyFrame(player);
+    }
+
+    CachedMovieFrame *next_frame_to_play = GleedGetCurrentCachedFrame(mov, GLEED_TRACK_TYPE_VIDEO);
+
+    while (GleedHasNextVideoFrame(mov) && next_frame_to_play && GleedTimecodeToMilliseconds(mov, next_frame_to_play->timecode) <= player->current_time)
+    {
+        /* Last frame is let go too, so the player still finishes */
+        const bool last = mov->current_frame + 1 >= mov->total_frames;
+
+        if (!last && !GleedIsVideoFrameSuperseded(mov, player->current_time))
+        {
+            break;
+        }
+
+        /* Suspended player leaves the decoder behind, it catches up from a keyframe when visible again */
+        if (player->visibility == GLEED_PLAYER_HIDDEN && !GleedSkipVideoFrame(mov))
+        {
+            return GLEED_PLAYER_UPDATE_ERROR;
+        }
+
+        GleedNextVideoFrame(mov);
+        next_frame_to_play = GleedGetCurrentCachedFrame(mov, GLEED_TRACK_TYPE_VIDEO);
+
+        if (player->visibility == GLEED_PLAYER_HIDDEN && GleedHasNextVideoFrame(mov) && GleedIsPlayerUpdateOverBudget(player))
+        {
+            result |= GLEED_PLAYER_UPDATE_BEHIND;
+            break;
+        }
+    }
+
+    if (GleedHasNextVideoFrame(mov))
+    {
+        player->next_video_frame_at = GleedTimecodeToMilliseconds(mov, next_frame_to_play->timecode);
+    }
+    else
+    {
+        player->finished = true;
+    }
+
+    return result;
+}
+
+/*
+    Decodes audio frames starting before the given time, and queues their samples for output.
+    When budgeted, the preload past the current time stops once the update budget is spent.
+    Samples already due are always decoded, video may have spent the budget and audio must not starve for it.
+*/
+static bool GleedDecodePlayerAudio(GleedMoviePlayer *player, Uint64 until, bool budgeted)
+{
+    CachedMovieFrame *next_frame_to_play = GleedGetCurrentCachedFrame(
+        player->mov, GLEED_TRACK_TYPE_AUDIO);
+
+    /*
+        This function does not account for seeks, so we decode EACH frame until we reach the current time
+        assuming that really given time has passed since last update
+    */
+    while (GleedHasNextAudioFrame(player->mov) && GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode) < until)
+    {
+        /*TODO: provide any recovery from such errors? maybe reset codec state */
+        if (!GleedDecodeAudioFrame(player->mov))
+        {
+            return false;
+        }
+
+        int samples_count;
+
+        const GleedMovieAudioSample *samples = GleedGetAudioSamples(player->mov, NULL, &samples_count);
+
+        if (samples_count > 0)
+        {
+            GleedAddAudioSamplesToPlayer(player, samples, samples_count);
+
+            /* If output is set up, add samples to stream right away and forget about them*/
+            if (player->output_audio_stream)
+            {
+                SDL_PutAudioStreamData(player->output_audio_stream, samples, samples_count * sizeof(GleedMovieAudioSample));
+                player->audio_buffer_count = 0;
+            }
+        }
+
+        GleedNextAudioFrame(player->mov);
+        next_frame_to_play = GleedGetCurrentCachedFrame(
+            player->mov, GLEED_TRACK_TYPE_AUDIO);
+
+        if (budgeted && GleedHasNextAudioFrame(player->mov) &&
+            GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode) >= player->current_time &&
+            GleedIsPlayerUpdateOverBudget(player))
+        {
+            break;
+        }
+    }
+
+    /* We will play next frame only after this timecode*/
+    if (next_frame_to_play)
+    {
+        player->next_audio_frame_at = GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode);
+    }
+
+    return true;
+}
+
+GleedMoviePlayerUpdateResult GleedUpdatePlayer(GleedMoviePlayer *player, int time_delta_ms)
+{
+    if (!check_player(player))
+        return GLEED_PLAYER_UPDATE_NONE;
+
+    /*0 is treated as no time has passed*/
+    if (time_delta_ms == 0)
+        return GLEED_PLAYER_UPDATE_NONE;
+
+    if (player->paused || player->finished)
+        return GLEED_PLAYER_UPDATE_NONE;
+
+    GleedMoviePlayerUpdateResult result = GLEED_PLAYER_UPDATE_NONE;
+
+    /* Decide how much time passed since last update based on second argument*/
+    const Uint64 time_passed = time_delta_ms < 0 ? SDL_GetTicks() - player->last_frame_at_ticks : time_delta_ms;
+
+    player->current_time += time_passed;
+
+    /*
+        Intuitively, we should record that at end of update,
+        but decoding can take quite a lot of time,
+        so the next update must account for it too
+    */
+    player->last_frame_at_ticks = SDL_GetTicks();
+
+    if (player->update_budget_ns > 0)
+    {
+        player->update_deadline_ns = SDL_GetTicksNS() + player->update_budget_ns;
+    }
+
+    if (player->video_playback && player->visibility == GLEED_PLAYER_VISIBLE && GleedCanPlaybackVideo(player->mov) && player->current_time >= player->next_video_frame_at)
+    {
+        if (!GleedAdaptPlayerVariant(player))
+        {
+            return GLEED_PLAYER_UPDATE_ERROR;
+        }
+    }
+
+    if (player->video_playback && GleedCanPlaybackVideo(player->mov) && player->current_time >= player->next_video_frame_at && player->video_queue)
+    {
+        const GleedMoviePlayerUpdateResult video_result = GleedUpdatePlayerQueuedVideo(player);
+
+        if (video_result == GLEED_PLAYER_UPDATE_ERROR)
+        {
+            return GLEED_PLAYER_UPDATE_ERROR;
+        }
+
+        result |= video_result;
+    }
+    else if (player->video_playback && GleedCanPlaybackVideo(player->mov) && player->current_time >= player->next_video_frame_at && player->visibility != GLEED_PLAYER_VISIBLE)
+    {
+        const GleedMoviePlayerUpdateResult video_result = GleedUpdatePlayerHiddenVideo(player);
+
+        if (video_result == GLEED_PLAYER_UPDATE_ERROR)
+        {
+            return GLEED_PLAYER_UPDATE_ERROR;
+        }
+
+        result |= video_result;
+    }
+    else if (player->video_playback && GleedCanPlaybackVideo(player->mov) && player->current_time >= player->next_video_frame_at)
+    {
+        /* Frame converted ahead by GleedPreparePlayer only has to reach the output texture */
+        if (player->video_frame_prepared)
+        {
+            player->video_frame_prepared = false;
+
+            if (player->output_texture_count > 0)
+            {
+                if (!GleedUpdateTextureFromSurface(player->mov->current_frame_surface, GleedGetNextPlayerOutputTexture(player)))
+                {
+                    return GLEED_PLAYER_UPDATE_ERROR;
+                }
+
+                GleedAdvancePlayerOutputTexture(player);
+            }
+        }
+
+        if (player->update_budget_ns > 0)
+        {
+            GleedSkipPlayerToDueKeyFrame(player);
+        }
+
+        CachedMovieFrame *next_frame_to_play = GleedGetCurrentCachedFrame(
+            player->mov, GLEED_TRACK_TYPE_VIDEO);
+
+        /*
+            This function does not account for seeks, so we decode EACH frame until we reach the current time
+            assuming that really given time has passed since last update.
+
+            Moreover, for some reasons quite a few .webm files I have tested do not have
+            keyframes set correctly, and even seeking back to them before decoding does not help.
+
+            This probably SHOULD be optimized, but I am not quite sure how for now.
+        */
+        while (GleedHasNextVideoFrame(player->mov) && next_frame_to_play && GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode) <= player->current_time)
+        {
+            /*
+                Only the last due frame will be shown, so the ones before it only need to keep the codec state -
+                converting them would just make us fall behind even more.
+            */
+            const bool superseded = GleedIsVideoFrameSuperseded(player->mov, player->current_time);
+
+            if (superseded)
+            {
+                if (!GleedSkipVideoFrame(player->mov))
+                {
+                    return GLEED_PLAYER_UPDATE_ERROR;
+                }
+            }
+            else
+            {
+                /* Image is converted right into the output, once we know the frame has one */
+                if (!GleedDecodeVideoFrameTo(player->mov, NULL, GLEED_VIDEO_DECODE_CONVERT_LATER))
+                {
+                    return GLEED_PLAYER_UPDATE_ERROR;
+                }
+
+                if (player->mov->video_frame_shown && !GleedOutputPlayerVideoFrame(player))
+                {
+                    return GLEED_PLAYER_UPDATE_ERROR;
+                }
+
+                /* Frames taken from the frame cache say nothing about what decoding costs */
+                if (player->mov->video_frame_shown && !player->mov->video_cache_hit)
+                {
+                    GleedSamplePlayerVariantCost(player, player->mov->last_frame_decode_ns);
+                }
+            }
+
+            GleedNextVideoFrame(player->mov);
+            next_frame_to_play = GleedGetCurrentCachedFrame(
+                player->mov, GLEED_TRACK_TYPE_VIDEO);
+
+            if (GleedIsPlayerUpdateOverBudget(player))
+            {
+                break;
+            }
+        }
+
+        if (next_frame_to_play)
+        {
+            player->next_video_frame_at = GleedTimecodeToMilliseconds(player->mov, next_frame_to_play->timecode);
+        }
+
+        /* Frames still due are left for the next update, which comes right back here as next_video_frame_at has passed */
+        if (GleedHasNextVideoFrame(player->mov) && next_frame_to_play && player->next_video_frame_at <= player->current_time)
+        {
+            result |= GLEED_PLAYER_UPDATE_BEHIND;
+        }
+
+        result |= GLEED_PLAYER_UPDATE_VIDEO;
+
+        /* Currently video is used as determining factor if movie has ended */
+        if (!GleedHasNextVideoFrame(player->mov))
+        {
+            player->finished = true;
+        }
+    }
+
+    /*
+       Only advance audio if we
+       1) have it enabled
+       2) have audio track
+       3) it's time to play next frame
+   */
+    if (player->audio_playback && GleedCanPlaybackAudio(player->mov) && player->current_time >= player->next_audio_frame_at)
+    {
+        /* Audio output is much more sensitive to delays or interruptions, so we load a bit more samples */
+        if (!GleedDecodePlayerAudio(player, player->current_time + GLEED_PLAYER_SOUND_PRELOAD_MS, true))
+        {
+            return GLEED_PLAYER_UPDATE_ERROR;
+        }
+
+        result |= GLEED_PLAYER_UPDATE_AUDIO;
+    }
+
+    return result;
+}
+
+void GleedAddAudioSamplesToPlayer(
+    GleedMoviePlayer *player,
+    const GleedMovieAudioSample *samples,
+    int count)
+{
+    if (!check_player(player))
+        return;
+
+    if (!samples || count <= 0)
+        return;
+
+    if (!player->audio_buffer)
+    {
+        /*Allocate a buffer for at least hardware-provided samples count + plus amount of samples for 1 second at given frequency */
+        player->audio_buffer_capacity = player->mov->audio_spec.freq * player->mov->audio_spec.channels + player->audio_output_samples_buffer_size;
+        player->audio_buffer = (GleedMovieAudioSample *)SDL_calloc(player->audio_buffer_capacity, sizeof(GleedMovieAudioSample));
+
+        if (!player->audio_buffer)
+        {
+            GleedSetError("Failed to allocate memory for audio buffer");
+            return;
+        }
+    }
+
+    if (player->audio_buffer_count + count > player->audio_buffer_capacity)
+    {
+        /* Rollback to start of buffer and start overwriting, user should've read them at this point */
+        player->audio_buffer_count = 0;
+    }
+
+    /* Copy the samples manually */
+    for (int s = 0; s < count; s++)
+    {
+        player->audio_buffer[player->audio_buffer_count + s] = samples[s];
+    }
+
+    player->audio_buffer_count += count;
+}
+
+bool GleedSetPlayerAudioOutput(GleedMoviePlayer *player, SDL_AudioDeviceID dev)
+{
+    if (!check_player(player))
+        return SDL_SetError("Invalid player");
+
+    if (dev == SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK)
+    {
+        return SDL_SetError("Audio output device must be already opened or 0 to disable");
+    }
+
+    if (!GleedCanPlaybackAudio(player->mov))
+    {
+        return GleedSetError("No audio track selected");
+    }
+
+    if (player->output_audio_stream)
+    {
+        SDL_DestroyAudioStream(player->output_audio_stream);
+        player->output_audio_stream = NULL;
+        player->bound_audio_device = 0;
+    }
+
+    /* If zero was provided for device id - user wants to stop audio output */
+    if (!dev)
+    {
+        return true;
+    }
+
+    SDL_AudioSpec dst_audio_spec;
+    if (!SDL_GetAudioDeviceFormat(dev, &dst_audio_spec, &player->audio_output_samples_buffer_size))
+    {
+        return GleedSetError("Failed to get audio device format: %s", SDL_GetError());
+    }
+
+    /* 1024 is the reasonable default?*/
+    if (!player->audio_output_samples_buffer_size)
+    {
+        player->audio_output_samples_buffer_size = 1024;
     }
 
     player->audio_output_samples_buffer_ms = ((Sint64)player->audio_output_samples_buffer_size * 1000) / dst_audio_spec.freq;
@@ -345,182 +985,639 @@ bool GleedSetPlayerAudioOutput(GleedMoviePlayer *player, SDL_AudioDeviceID dev)
         return GleedSetError("Failed to bind audio stream: %s", SDL_GetError());
     }
 
-    player->bound_audio_device = dev;
+    player->bound_audio_device = dev;
+
+    return true;
+}
+
+const GleedMovieAudioSample *GleedGetPlayerAvailableAudioSamples(
+    GleedMoviePlayer *player,
+    int *count)
+{
+    if (!check_player(player))
+        return NULL;
+
+    if (!player->audio_buffer)
+        return NULL;
+
+    if (count)
+        *count = player->audio_buffer_count;
+
+    return player->audio_buffer;
+}
+
+void GleedPausePlayer(GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return;
+
+    player->paused = true;
+
+    if (player->output_audio_stream)
+    {
+        SDL_UnbindAudioStream(player->output_audio_stream);
+    }
+}
+
+void GleedResumePlayer(GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return;
+
+    player->paused = false;
+    player->last_frame_at_ticks = SDL_GetTicks();
+
+    if (player->output_audio_stream)
+    {
+        SDL_BindAudioStream(player->bound_audio_device, player->output_audio_stream);
+    }
+}
+
+bool GleedIsPlayerPaused(GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return false;
+
+    return player->paused;
+}
+
+float GleedGetPlayerCurrentTimeSeconds(GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return 0;
+
+    return (float)player->current_time / 1000.0f;
+}
+
+Uint64 GleedGetPlayerCurrentTime(GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return 0;
+
+    return player->current_time;
+}
+
+bool GleedSetPlayerVideoOutputTexture(
+    GleedMoviePlayer *player,
+    SDL_Texture *texture)
+{
+    if (!check_player(player))
+        return SDL_SetError("Invalid player");
+
+    if (texture == NULL)
+    {
+        GleedReleasePlayerOutputTextures(player);
+        return true;
+    }
+
+    if (!GleedCanPlaybackVideo(player->mov))
+    {
+        return SDL_SetError("No video playback available, check if video track is selected");
+    }
+
+    if (texture->format != player->mov->video_pixel_format)
+    {
+        return SDL_SetError("Texture format does not match the video frame format");
+    }
+
+    GleedReleasePlayerOutputTextures(player);
+    player->output_pixels = NULL;
+
+    /* User texture is a ring of one, it always holds the current frame */
+    player->output_textures[0] = texture;
+    player->output_texture_count = 1;
+    player->output_video_frame_texture = texture;
+
+    return true;
+}
+
+bool GleedSetPlayerVideoOutputTextures(
+    GleedMoviePlayer *player,
+    SDL_Renderer *renderer,
+    int count)
+{
+    if (!check_player(player))
+        return GleedSetError("Invalid player");
+
+    if (count < 0 || count > GLEED_PLAYER_MAX_OUTPUT_TEXTURES)
+        return GleedSetError("Output texture count must be between 0 and %d", GLEED_PLAYER_MAX_OUTPUT_TEXTURES);
+
+    if (count == 0)
+    {
+        GleedReleasePlayerOutputTextures(player);
+        return true;
+    }
+
+    if (!renderer)
+        return GleedSetError("Invalid renderer");
+
+    if (!GleedCanPlaybackVideo(player->mov))
+        return GleedSetError("No video track selected");
+
+    /* Old ring stays in place until the new one is complete */
+    SDL_Texture *textures[GLEED_PLAYER_MAX_OUTPUT_TEXTURES];
+
+    for (int i = 0; i < count; i++)
+    {
+        textures[i] = GleedCreatePlaybackTexture(player->mov, renderer);
+
+        if (!textures[i])
+        {
+            for (int j = 0; j < i; j++)
+            {
+                SDL_DestroyTexture(textures[j]);
+            }
+
+            return false;
+        }
+    }
+
+    GleedReleasePlayerOutputTextures(player);
+    player->output_pixels = NULL;
+
+    SDL_memcpy(player->output_textures, textures, count * sizeof(SDL_Texture *));
+    player->output_texture_count = count;
+    player->owns_output_textures = true;
+
+    return true;
+}
+
+SDL_Texture *GleedGetPlayerVideoOutputTexture(
+    GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return NULL;
+
+    return player->output_video_frame_texture;
+}
+
+bool GleedSetPlayerVideoOutputBuffer(
+    GleedMoviePlayer *player,
+    void *pixels,
+    int pitch,
+    SDL_PixelFormat format)
+{
+    if (!check_player(player))
+        return GleedSetError("Invalid player");
+
+    if (!pixels)
+    {
+        player->output_pixels = NULL;
+        return true;
+    }
+
+    if (!GleedCanPlaybackVideo(player->mov))
+        return GleedSetError("No video track selected");
+
+    if (!GleedCheckVideoOutputBuffer(player->mov, pixels, pitch, format))
+        return false;
+
+    GleedReleasePlayerOutputTextures(player);
+
+    player->output_pixels = pixels;
+    player->output_pitch = pitch;
+    player->output_format = format;
+    GleedGetVideoOutputSize(player->mov, &player->output_w, &player->output_h);
 
     return true;
 }
 
-const GleedMovieAudioSample *GleedGetPlayerAvailableAudioSamples(
-    GleedMoviePlayer *player,
-    int *count)
+const SDL_Surface *GleedGetPlayerCurrentVideoFrameSurface(
+    GleedMoviePlayer *player)
 {
     if (!check_player(player))
         return NULL;
 
-    if (!player->audio_buffer)
-        return NULL;
+    /* Decoding synchronously, frames are converted into the movie's own surface */
+    if (!player->video_queue)
+        return GleedGetVideoFrameSurface(player->mov);
 
-    if (count)
-        *count = player->audio_buffer_count;
+    return player->current_video_frame_surface;
+}
 
-    return player->audio_buffer;
+bool GleedHasPlayerFinished(GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return false;
+
+    return player->finished;
 }
 
-void GleedPausePlayer(GleedMoviePlayer *player)
+bool GleedIsPlayerAudioEnabled(GleedMoviePlayer *player)
 {
     if (!check_player(player))
-        return;
+        return false;
 
-    player->paused = true;
+    return player->audio_playback;
+}
 
-    if (player->output_audio_stream)
-    {
-        SDL_UnbindAudioStream(player->output_audio_stream);
-    }
+bool GleedIsPlayerVideoEnabled(GleedMoviePlayer *player)
+{
+    if (!check_player(player))
+        return false;
+
+    return player->video_playback;
 }
 
-void GleedResumePlayer(GleedMoviePlayer *player)
+void GleedSetPlayerAudioEnabled(GleedMoviePlayer *player, bool enabled)
 {
     if (!check_player(player))
         return;
 
-    player->paused = false;
-    player->last_frame_at_ticks = SDL_GetTicks();
-
-    if (player->output_audio_stream)
+    if (!GleedCanPlaybackAudio(player->mov))
     {
-        SDL_BindAudioStream(player->bound_audio_device, player->output_audio_stream);
+        return;
     }
+
+    player->audio_playback = enabled;
 }
 
-bool GleedIsPlayerPaused(GleedMoviePlayer *player)
+bool GleedGetPlayerVideoStats(GleedMoviePlayer *player, GleedMovieVideoStats *stats)
 {
     if (!check_player(player))
-        return false;
+        return GleedSetError("Invalid player");
 
-    return player->paused;
+    if (player->video_queue && stats)
+    {
+        GleedGetVideoFrameQueueStats(player->video_queue, stats);
+        return true;
+    }
+
+    return GleedGetVideoStats(player->mov, stats);
 }
 
-float GleedGetPlayerCurrentTimeSeconds(GleedMoviePlayer *player)
+void GleedSetPlayerUpdateBudget(GleedMoviePlayer *player, Uint32 budget_us)
 {
     if (!check_player(player))
-        return 0;
+        return;
 
-    return (float)player->current_time / 1000.0f;
+    player->update_budget_ns = SDL_US_TO_NS((Uint64)budget_us);
 }
 
-Uint64 GleedGetPlayerCurrentTime(GleedMoviePlayer *player)
+Uint32 GleedGetPlayerUpdateBudget(GleedMoviePlayer *player)
 {
     if (!check_player(player))
         return 0;
 
-    return player->current_time;
+    return (Uint32)SDL_NS_TO_US(player->update_budget_ns);
 }
 
-bool GleedSetPlayerVideoOutputTexture(
-    GleedMoviePlayer *player,
-    SDL_Texture *texture)
+bool GleedSetPlayerDecodeAhead(GleedMoviePlayer *player, int frames)
 {
     if (!check_player(player))
-        return SDL_SetError("Invalid player");
+        return GleedSetError("Invalid player");
 
-    if (texture == NULL)
+    if (frames < 0)
+        return GleedSetError("Decode-ahead frames count cannot be negative");
+
+    if (player->video_queue)
     {
-        player->output_video_frame_texture = NULL;
-        return true;
+        GleedDestroyVideoFrameQueue(player->video_queue);
+        player->video_queue = NULL;
     }
 
-    if (!player->mov->current_frame_surface)
+    player->decode_ahead_frames = frames;
+
+    if (frames == 0 || player->visibility != GLEED_PLAYER_VISIBLE)
+        return true;
+
+    if (!GleedCanPlaybackVideo(player->mov))
+        return GleedSetError("No video track selected");
+
+    return GleedStartPlayerDecodeAhead(player, player->mov);
+}
+
+void GleedSetPlayerVideoEnabled(GleedMoviePlayer *player, bool enabled)
+{
+    if (!check_player(player))
+        return;
+
+    if (!GleedCanPlaybackVideo(player->mov))
     {
-        return SDL_SetError("No video playback available, check if video track is selected");
+        return;
     }
 
-    if (texture->format != player->mov->current_frame_surface->format)
+    player->video_playback = enabled;
+}
+
+/*
+    Decodes and converts the next displayable frame ahead of time. Textures may only be written from
+    the render thread, so with texture output the frame waits in the movie's surface for the first update.
+*/
+static bool GleedPreparePlayerVideoFrame(GleedMoviePlayer *player)
+{
+    GleedMovie *mov = player->mov;
+
+    while (GleedHasNextVideoFrame(mov))
     {
-        return SDL_SetError("Texture format does not match the video frame format");
-    }
+        const CachedMovieFrame *frame = GleedGetCurrentCachedFrame(mov, GLEED_TRACK_TYPE_VIDEO);
+        const Uint64 frame_at = GleedTimecodeToMilliseconds(mov, frame->timecode);
 
-    player->output_video_frame_texture = texture;
+        if (!GleedDecodeVideoFrameTo(mov, NULL, GLEED_VIDEO_DECODE_CONVERT_LATER))
+        {
+            return false;
+        }
+
+        GleedNextVideoFrame(mov);
+
+        /* Hidden frames only feed the decoder, the first shown one is what we are after */
+        if (!mov->video_frame_shown)
+        {
+            continue;
+        }
+
+        if (player->output_pixels)
+        {
+            int w, h;
+            GleedGetVideoOutputSize(mov, &w, &h);
+
+            if (!GleedCheckPlayerOutputBuffer(player, w, h))
+            {
+                return false;
+            }
+
+            if (!GleedConvertVideoFrameToPixels(mov, player->output_pixels, player->output_pitch, player->output_format))
+            {
+                return false;
+            }
+        }
+        else if (!GleedConvertVideoFrameTo(mov, NULL))
+        {
+            return false;
+        }
+
+        player->video_frame_prepared = true;
+        player->next_video_frame_at = frame_at;
+
+        return true;
+    }
 
     return true;
 }
 
-const SDL_Surface *GleedGetPlayerCurrentVideoFrameSurface(
-    GleedMoviePlayer *player)
+bool GleedPreparePlayer(GleedMoviePlayer *player)
 {
     if (!check_player(player))
-        return NULL;
+        return GleedSetError("Invalid player");
 
-    return player->current_video_frame_surface;
+    GleedMovie *mov = player->mov;
+
+    if (player->video_playback && player->visibility == GLEED_PLAYER_VISIBLE && GleedCanPlaybackVideo(mov) && !player->video_frame_prepared)
+    {
+        /* Decoder thread is on it already, its first frame just has to be there before playback starts */
+        if (player->video_queue)
+        {
+            if (!GleedWaitVideoFrameQueue(player->video_queue))
+            {
+                return false;
+            }
+        }
+        else if (!GleedPreparePlayerVideoFrame(player))
+        {
+            return false;
+        }
+    }
+
+    /* Enough audio for the device to start with a full buffer, this also sets up the audio decoder */
+    if (player->audio_playback && GleedCanPlaybackAudio(mov))
+    {
+        const Uint64 preload_ms = SDL_max(GLEED_PLAYER_SOUND_PRELOAD_MS, player->audio_output_samples_buffer_ms);
+
+        if (!GleedDecodePlayerAudio(player, player->current_time + preload_ms, false))
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
-bool GleedHasPlayerFinished(GleedMoviePlayer *player)
+bool GleedSetPlayerVisibility(GleedMoviePlayer *player, GleedPlayerVisibility visibility)
 {
     if (!check_player(player))
+        return GleedSetError("Invalid player");
+
+    if (visibility < GLEED_PLAYER_VISIBLE || visibility > GLEED_PLAYER_SUSPENDED)
+        return GleedSetError("Invalid player visibility %d", (int)visibility);
+
+    if (visibility == player->visibility)
+        return true;
+
+    player->visibility = visibility;
+
+    if (visibility != GLEED_PLAYER_VISIBLE)
+    {
+        /* Prepared frame is stale by the time the player is visible again */
+        player->video_frame_prepared = false;
+
+        /* Frames the decoder thread has converted ahead are simply skipped, its decoder state stays valid */
+        if (player->video_queue)
+        {
+            GleedDestroyVideoFrameQueue(player->video_queue);
+            player->video_queue = NULL;
+        }
+
+        return true;
+    }
+
+    GleedMovie *mov = player->mov;
+
+    /* Decoder of a suspended player is behind the frame on screen, this decodes at most one GOP */
+    if (GleedCanPlaybackVideo(mov) && mov->current_frame < mov->total_frames && mov->decoder_next_frame != mov->current_frame)
+    {
+        if (!GleedCatchUpVideoDecoder(mov, mov->current_frame))
+        {
+            return false;
+        }
+    }
+
+    if (GleedShouldPlayerDecodeAhead(player) && !GleedStartPlayerDecodeAhead(player, mov))
+    {
         return false;
+    }
 
-    return player->finished;
+    return true;
 }
 
-bool GleedIsPlayerAudioEnabled(GleedMoviePlayer *player)
+GleedPlayerVisibility GleedGetPlayerVisibility(GleedMoviePlayer *player)
 {
     if (!check_player(player))
-        return false;
+        return GLEED_PLAYER_VISIBLE;
 
-    return player->audio_playback;
+    return player->visibility;
 }
 
-bool GleedIsPlayerVideoEnabled(GleedMoviePlayer *player)
+bool GleedSetPlayerColorTransform(GleedMoviePlayer *player, const GleedColorTransform *transform)
 {
     if (!check_player(player))
-        return false;
+        return GleedSetError("Invalid player");
 
-    return player->video_playback;
+    return GleedSetVideoColorTransform(player->mov, transform);
 }
 
-void GleedSetPlayerAudioEnabled(GleedMoviePlayer *player, bool enabled)
+/* Audio decoders need a few packets before the target to produce valid output again, those are decoded and discarded */
+static bool GleedPrerollPlayerAudio(GleedMovie *mov, Uint64 time_ms)
 {
-    if (!check_player(player))
-        return;
+    GleedMovieTrack *audio_track = GleedGetAudioTrack(mov);
 
-    if (!GleedCanPlaybackAudio(player->mov))
+    const Uint32 target_frame = GleedFindFrameAtTimecode(mov, mov->current_audio_track, GleedMillisecondsToTimecode(mov, time_ms));
+
+    Uint32 first_frame = target_frame;
+
+    if (mov->audio_codec == GLEED_CODEC_TYPE_OPUS)
     {
-        return;
+        /* Matroska spec requires decoding at least SeekPreRoll worth of Opus audio before the target */
+        const Uint64 pre_roll_ms = GleedMatroskaTicksToMilliseconds(mov, audio_track->seek_pre_roll);
+        const Uint64 pre_roll_from = time_ms > pre_roll_ms ? time_ms - pre_roll_ms : 0;
+
+        first_frame = GleedFindFrameAtTimecode(mov, mov->current_audio_track, GleedMillisecondsToTimecode(mov, pre_roll_from));
+    }
+    else if (target_frame > 0)
+    {
+        /* Vorbis blocks overlap, so the first packet after a reset only primes the decoder */
+        first_frame = target_frame - 1;
     }
 
-    player->audio_playback = enabled;
+    GleedResetAudioDecoder(mov);
+
+    for (mov->current_audio_frame = first_frame; mov->current_audio_frame < target_frame; mov->current_audio_frame++)
+    {
+        if (!GleedDecodeAudioFrame(mov))
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
-void GleedSetPlayerVideoEnabled(GleedMoviePlayer *player, bool enabled)
+bool GleedSeekPlayer(GleedMoviePlayer *player, Uint64 time_ms)
 {
     if (!check_player(player))
-        return;
+        return GleedSetError("Invalid player");
 
-    if (!GleedCanPlaybackVideo(player->mov))
+    GleedMovie *mov = player->mov;
+
+    /* Decoder thread owns the video decoding state, so it has to go before we touch it */
+    if (player->video_queue)
     {
-        return;
+        GleedDestroyVideoFrameQueue(player->video_queue);
+        player->video_queue = NULL;
     }
 
-    player->video_playback = enabled;
+    player->current_time = time_ms;
+    player->video_frame_prepared = false;
+    player->next_video_frame_at = time_ms;
+    player->next_audio_frame_at = time_ms;
+    player->finished = false;
+    player->last_frame_at_ticks = SDL_GetTicks();
+
+    /*
+        Video is positioned on the frame which is on screen at the given time.
+        GleedSeekFrame decodes at most one GOP to get there, and the frame itself is already due,
+        so the next update decodes and shows it right away.
+    */
+    if (GleedCanPlaybackVideo(mov))
+    {
+        const Uint32 frame = GleedFindFrameAtTimecode(mov, mov->current_video_track, GleedMillisecondsToTimecode(mov, time_ms));
+
+        if (GleedSeekFrame(mov, frame) < 0)
+        {
+            return false;
+        }
+    }
+
+    if (GleedCanPlaybackAudio(mov))
+    {
+        if (!GleedPrerollPlayerAudio(mov, time_ms))
+        {
+            return false;
+        }
+    }
+
+    /* Samples from before the seek must not be heard */
+    player->audio_buffer_count = 0;
+
+    if (player->output_audio_stream)
+    {
+        SDL_ClearAudioStream(player->output_audio_stream);
+    }
+
+    if (GleedShouldPlayerDecodeAhead(player) && !GleedStartPlayerDecodeAhead(player, mov))
+    {
+        return false;
+    }
+
+    return true;
 }
 
-/*
+bool GleedSeekPlayerSeconds(GleedMoviePlayer *player, float time_s)
+{
+    if (time_s < 0)
+        return GleedSetError("Seek time cannot be negative");
 
-Kinda complex to implement efficiently, so left as TODO.
+    return GleedSeekPlayer(player, (Uint64)(time_s * 1000));
+}
 
-void GleedSeekPlayer(GleedMoviePlayer *player, Uint64 time_ms)
+bool GleedAddPlayerVariant(GleedMoviePlayer *player, GleedMovie *mov, int video_track)
 {
     if (!check_player(player))
-        return;
+        return GleedSetError("Invalid player");
 
-    player->current_time = time_ms;
+    if (!mov)
+        return GleedSetError("Invalid movie");
 
-    player->next_video_frame_at = 0;
-    player->next_audio_frame_at = 0;
-    player->finished = false;
+    if (video_track < 0 || video_track >= (int)mov->ntracks || mov->tracks[video_track].type != GLEED_TRACK_TYPE_VIDEO)
+        return GleedSetError("Track %d is not a video track", video_track);
+
+    if (!GleedCanPlaybackVideo(player->mov))
+        return GleedSetError("Player has no video to add variants to");
+
+    /* Movie the player was created with is the first variant */
+    if (player->variant_count == 0)
+    {
+        player->variants[0].mov = player->mov;
+        player->variants[0].video_track = player->mov->current_video_track;
+        player->variant_count = 1;
+    }
+
+    if (player->variant_count >= GLEED_PLAYER_MAX_VARIANTS)
+        return GleedSetError("Too many player variants, at most %d are supported", GLEED_PLAYER_MAX_VARIANTS);
+
+    GleedMovie *first_mov = player->variants[0].mov;
+
+    /* Converted frames go to the same textures and buffers whichever variant they come from */
+    if (mov->tracks[video_track].video_alpha != first_mov->tracks[player->variants[0].video_track].video_alpha)
+        return GleedSetError("Variant must match the alpha channel of the player's movie");
+
+    if (mov != first_mov)
+    {
+        if (GleedCanPlaybackAudio(mov) != GleedCanPlaybackAudio(first_mov))
+            return GleedSetError("Variant must have the same audio as the player's movie");
+
+        if (GleedCanPlaybackAudio(mov) && (mov->audio_spec.freq != first_mov->audio_spec.freq || mov->audio_spec.channels != first_mov->audio_spec.channels))
+            return GleedSetError("Variant audio format does not match the player's movie");
+    }
+
+    player->variants[player->variant_count].mov = mov;
+    player->variants[player->variant_count].video_track = video_track;
+    player->variant_count++;
+
+    return true;
 }
 
-void GleedSeekPlayerSeconds(GleedMoviePlayer *player, float time_s)
+int GleedGetPlayerVariant(GleedMoviePlayer *player)
 {
-    return GleedSeekPlayer(player, (Uint64)(time_s * 1000));
-}*/
\ No newline at end of file
+    if (!check_player(player))
+        return 0;
+
+    return player->current_variant;
+}
+
+void GleedSetPlayerVariantBudget(GleedMoviePlayer *player, Uint32 budget_us)
+{
+    if (!check_player(player))
+        return;
+
+    player->variant_budget_ns = SDL_US_TO_NS((Uint64)budget_us);
+}
@@ -0,0 +1,325 @@
+#include "gleed_movie_internal.h"
+
+/* Decoder thread updates movie stats unlocked, so readers only ever see this copy, taken under the queue lock */
+static void GleedSnapshotVideoFrameQueueStats(GleedVideoFrameQueue *queue)
+{
+    queue->stats = queue->mov->video_stats;
+}
+
+static void GleedFailVideoFrameQueue(GleedVideoFrameQueue *queue)
+{
+    SDL_LockMutex(queue->lock);
+    GleedSnapshotVideoFrameQueueStats(queue);
+    queue->failed = true;
+    SDL_strlcpy(queue->error, GleedGetError(), sizeof(queue->error));
+    SDL_BroadcastCondition(queue->cond);
+    SDL_UnlockMutex(queue->lock);
+}
+
+static int GleedVideoDecoderThread(void *data)
+{
+    GleedVideoFrameQueue *queue = (GleedVideoFrameQueue *)data;
+    GleedMovie *mov = queue->mov;
+
+    for (;;)
+    {
+        SDL_LockMutex(queue->lock);
+
+        /* Wait until the player pops something, so we always have a free slot to convert into */
+        while (!queue->quit && queue->count >= queue->capacity)
+        {
+            SDL_WaitCondition(queue->cond, queue->lock);
+        }
+
+        if (queue->quit)
+        {
+            SDL_UnlockMutex(queue->lock);
+            break;
+        }
+
+        /* Slot past the tail is never touched by the consumer, so it's safe to convert into it unlocked */
+        GleedQueuedVideoFrame *slot = &queue->frames[(queue->head + queue->count) % queue->capacity];
+
+        const Uint64 playhead = queue->playhead;
+
+        SDL_UnlockMutex(queue->lock);
+
+        if (!GleedHasNextVideoFrame(mov))
+        {
+            SDL_LockMutex(queue->lock);
+            GleedSnapshotVideoFrameQueueStats(queue);
+            queue->eof = true;
+            SDL_BroadcastCondition(queue->cond);
+            SDL_UnlockMutex(queue->lock);
+            break;
+        }
+
+        const Uint32 frame = mov->current_frame;
+        const CachedMovieFrame *cached_frame = GleedGetCurrentCachedFrame(mov, GLEED_TRACK_TYPE_VIDEO);
+        const Uint64 pts = GleedTimecodeToMilliseconds(mov, cached_frame->timecode);
+
+        /* When running behind the player, frames it would drop anyway are not worth converting */
+        const bool convert = !GleedIsVideoFrameSuperseded(mov, playhead);
+
+        const GleedVideoDecodeFlags flags = convert ? GLEED_VIDEO_DECODE_CONVERT : GLEED_VIDEO_DECODE_ONLY | GLEED_VIDEO_DECODE_ALLOW_DROP;
+
+        if (!GleedDecodeVideoFrameTo(mov, slot->surface, flags))
+        {
+            GleedFailVideoFrameQueue(queue);
+            break;
+        }
+
+        GleedNextVideoFrame(mov);
+
+        /* Hidden and skipped frames only advanced the decoder state, nothing to present */
+        if (!convert || !mov->video_frame_shown)
+        {
+            continue;
+        }
+
+        SDL_LockMutex(queue->lock);
+        GleedSnapshotVideoFrameQueueStats(queue);
+        slot->pts = pts;
+        slot->frame = frame;
+        slot->decode_ns = mov->last_frame_decode_ns;
+        queue->count++;
+        SDL_BroadcastCondition(queue->cond);
+        SDL_UnlockMutex(queue->lock);
+    }
+
+    return 0;
+}
+
+GleedVideoFrameQueue *GleedCreateVideoFrameQueue(GleedMovie *mov, Uint32 capacity)
+{
+    if (!mov || capacity == 0)
+    {
+        GleedSetError("Invalid movie or queue capacity");
+        return NULL;
+    }
+
+    if (!GleedCanPlaybackVideo(mov))
+    {
+        GleedSetError("No video track selected");
+        return NULL;
+    }
+
+    GleedVideoFrameQueue *queue = (GleedVideoFrameQueue *)SDL_calloc(1, sizeof(GleedVideoFrameQueue));
+
+    if (!queue)
+    {
+        GleedSetError("Failed to allocate memory for video frame queue");
+        return NULL;
+    }
+
+    queue->mov = mov;
+    queue->capacity = capacity;
+    queue->stats = mov->video_stats;
+    queue->lock = SDL_CreateMutex();
+    queue->cond = SDL_CreateCondition();
+    queue->frames = (GleedQueuedVideoFrame *)SDL_calloc(capacity, sizeof(GleedQueuedVideoFrame));
+
+    if (!queue->lock || !queue->cond || !queue->frames)
+    {
+        GleedSetError("Failed to create video frame queue: %s", SDL_GetError());
+        GleedDestroyVideoFrameQueue(queue);
+        return NULL;
+    }
+
+    int w, h;
+    GleedGetVideoOutputSize(mov, &w, &h);
+
+    for (Uint32 i = 0; i < capacity; i++)
+    {
+        queue->frames[i].surface = GleedCreateVideoFrameSurface(mov, w, h);
+
+        if (!queue->frames[i].surface)
+        {
+            GleedDestroyVideoFrameQueue(queue);
+            return NULL;
+        }
+    }
+
+    queue->thread = SDL_CreateThread(GleedVideoDecoderThread, "GleedVideoDecoder", queue);
+
+    if (!queue->thread)
+    {
+        GleedSetError("Failed to create video decoder thread: %s", SDL_GetError());
+        GleedDestroyVideoFrameQueue(queue);
+        return NULL;
+    }
+
+    return queue;
+}
+
+void GleedDestroyVideoFrameQueue(GleedVideoFrameQueue *queue)
+{
+    if (!queue)
+        return;
+
+    if (queue->thread)
+    {
+        SDL_LockMutex(queue->lock);
+        queue->quit = true;
+        SDL_BroadcastCondition(queue->cond);
+        SDL_UnlockMutex(queue->lock);
+
+        SDL_WaitThread(queue->thread, NULL);
+    }
+
+    /* Decoder thread is gone, movie stats are ours again */
+    queue->mov->video_stats.late_frames += queue->late_frames;
+
+    if (queue->frames)
+    {
+        for (Uint32 i = 0; i < queue->capacity; i++)
+        {
+            if (queue->frames[i].surface)
+            {
+                SDL_DestroySurface(queue->frames[i].surface);
+            }
+        }
+
+        SDL_free(queue->frames);
+    }
+
+    if (queue->cond)
+    {
+        SDL_DestroyCondition(queue->cond);
+    }
+
+    if (queue->lock)
+    {
+        SDL_DestroyMutex(queue->lock);
+    }
+
+    SDL_free(queue);
+}
+
+bool GleedPopVideoFrame(GleedVideoFrameQueue *queue, Uint64 time, SDL_Surface **surface, Uint64 *decode_ns, bool *popped)
+{
+    *popped = false;
+
+    bool freed_slots = false;
+
+    SDL_LockMutex(queue->lock);
+
+    if (queue->failed)
+    {
+        SDL_UnlockMutex(queue->lock);
+        return GleedSetError("%s", queue->error);
+    }
+
+    /*
+        Everything that is due by now is dropped except the latest frame,
+        which is handed over to the caller by swapping surfaces - no pixels are copied.
+        Caller's previous surface takes place of the popped one in the ring.
+    */
+    queue->playhead = time;
+
+    while (queue->count > 0 && queue->frames[queue->head].pts <= time)
+    {
+        const bool is_latest_due = queue->count == 1 || queue->frames[(queue->head + 1) % queue->capacity].pts > time;
+
+        if (!is_latest_due)
+        {
+            queue->late_frames++;
+        }
+
+        if (is_latest_due)
+        {
+            GleedQueuedVideoFrame *slot = &queue->frames[queue->head];
+
+            SDL_Surface *displayed_surface = slot->surface;
+
+            if (*surface)
+            {
+                slot->surface = *surface;
+            }
+            else
+            {
+                slot->surface = GleedCreateVideoFrameSurface(queue->mov, displayed_surface->w, displayed_surface->h);
+            }
+
+            if (!slot->surface)
+            {
+                slot->surface = displayed_surface;
+                SDL_UnlockMutex(queue->lock);
+                return false;
+            }
+
+            *surface = displayed_surface;
+            *decode_ns = slot->decode_ns;
+            *popped = true;
+        }
+
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        freed_slots = true;
+    }
+
+    if (freed_slots)
+    {
+        SDL_BroadcastCondition(queue->cond);
+    }
+
+    SDL_UnlockMutex(queue->lock);
+
+    return true;
+}
+
+bool GleedPeekVideoFrameTime(GleedVideoFrameQueue *queue, Uint64 *pts)
+{
+    SDL_LockMutex(queue->lock);
+
+    const bool has_frame = queue->count > 0;
+
+    if (has_frame)
+    {
+        *pts = queue->frames[queue->head].pts;
+    }
+
+    SDL_UnlockMutex(queue->lock);
+
+    return has_frame;
+}
+
+bool GleedIsVideoFrameQueueDrained(GleedVideoFrameQueue *queue)
+{
+    SDL_LockMutex(queue->lock);
+
+    const bool drained = queue->eof && queue->count == 0;
+
+    SDL_UnlockMutex(queue->lock);
+
+    return drained;
+}
+
+bool GleedWaitVideoFrameQueue(GleedVideoFrameQueue *queue)
+{
+    SDL_LockMutex(queue->lock);
+
+    while (queue->count == 0 && !queue->eof && !queue->failed)
+    {
+        SDL_WaitCondition(queue->cond, queue->lock);
+    }
+
+    const bool failed = queue->failed;
+
+    if (failed)
+    {
+        GleedSetError("%s", queue->error);
+    }
+
+    SDL_UnlockMutex(queue->lock);
+
+    return !failed;
+}
+
+void GleedGetVideoFrameQueueStats(GleedVideoFrameQueue *queue, GleedMovieVideoStats *stats)
+{
+    SDL_LockMutex(queue->lock);
+    *stats = queue->stats;
+    stats->late_frames += queue->late_frames;
+    SDL_UnlockMutex(queue->lock);
+}
@@ -0,0 +1,230 @@
+#include "gleed_movie_internal.h"
+
+/* Beyond that, decoders mostly wait on each other for the IO lock and the callback */
+#define GLEED_RANGE_MAX_THREADS 16
+
+typedef struct
+{
+    Uint32 key_frame; /**< Keyframe the group of pictures starts with */
+    Uint32 end;       /**< One past the last frame of the group to decode */
+} GleedRangeGroup;
+
+typedef struct
+{
+    GleedMovie *movie;
+    Uint32 first; /**< First frame reported to the callback, frames before it only rebuild decoder references */
+
+    const GleedRangeGroup *groups; /**< Groups of pictures covering the range, one job each */
+
+    GleedDecodeRangeCallback callback;
+    void *userdata;
+    SDL_Mutex *callback_lock; /**< Callback is never called concurrently */
+
+    GleedColorTransformTables *color; /**< Colour transform of the movie when decoding started, used for the whole range */
+    GleedVideoDecodeQuality quality;  /**< Decode quality of the movie when decoding started, used for the whole range */
+} GleedRangeBatch;
+
+typedef struct
+{
+    GleedVPXDecoder *decoder;       /**< Colour decoder, reused for every group, as each starts at a keyframe */
+    GleedVPXDecoder *alpha_decoder; /**< Alpha decoder, created with the first frame carrying alpha */
+    Uint8 *data;                    /**< Packet buffer */
+    Uint32 data_size;               /**< Capacity of the packet buffer */
+    Uint8 *alpha_data;              /**< Alpha packet buffer */
+    Uint32 alpha_data_size;         /**< Capacity of the alpha packet buffer */
+    SDL_Surface *surface;           /**< Frames are converted here before they are passed to the callback */
+} GleedRangeWorker;
+
+static bool GleedDecodeRangeGroup(GleedWorkerPool *pool, void *data, int job)
+{
+    GleedRangeBatch *batch = (GleedRangeBatch *)pool->userdata;
+    GleedRangeWorker *worker = (GleedRangeWorker *)data;
+    const GleedRangeGroup *group = &batch->groups[job];
+    GleedMovie *movie = batch->movie;
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    GleedConvertParams params;
+    params.crop = &movie->video_crop;
+    params.premultiply = movie->video_premultiplied_alpha;
+    params.fast = batch->quality >= GLEED_VIDEO_QUALITY_FAST;
+    params.mipmaps = movie->video_mipmaps;
+    params.color = batch->color;
+
+    for (Uint32 frame = group->key_frame; frame < group->end; frame++)
+    {
+        if (GleedIsWorkerPoolStopped(pool))
+            return true;
+
+        const CachedMovieFrame *cached_frame = &frames[frame];
+
+        if (!GleedReadVideoPacket(movie, frame, &worker->data, &worker->data_size))
+            return false;
+
+        GleedVideoFrameYUV yuv;
+        bool shown;
+
+        if (!GleedDecodeVPXPacket(worker->decoder, worker->data, cached_frame->size, frame, &yuv, &shown))
+            return false;
+
+        /* Alpha stream keeps its own references, so it's decoded for every frame carrying it */
+        GleedVideoFrameYUV alpha_yuv;
+        bool alpha_shown = false;
+
+        if (cached_frame->alpha_size > 0)
+        {
+            if (!worker->alpha_decoder)
+            {
+                worker->alpha_decoder = GleedCreateVPXDecoder(movie->video_codec);
+
+                if (!worker->alpha_decoder)
+                    return false;
+
+                GleedSetVPXDecoderQuality(worker->alpha_decoder, batch->quality);
+            }
+
+            if (!GleedReadVideoAlphaPacket(movie, frame, &worker->alpha_data, &worker->alpha_data_size))
+                return false;
+
+            if (!GleedDecodeVPXPacket(worker->alpha_decoder, worker->alpha_data, cached_frame->alpha_size, frame, &alpha_yuv, &alpha_shown))
+                return false;
+        }
+
+        if (!shown || frame < batch->first)
+            continue;
+
+        if (!GleedConvertYUVFrame(&yuv, alpha_shown ? &alpha_yuv : NULL, &params, worker->surface))
+            return false;
+
+        const Uint64 time_ms = GleedTimecodeToMilliseconds(movie, cached_frame->timecode);
+
+        SDL_LockMutex(batch->callback_lock);
+
+        /* Another worker's callback may have asked to stop while we were converting */
+        const bool proceed = !GleedIsWorkerPoolStopped(pool) && batch->callback(batch->userdata, frame, time_ms, worker->surface);
+
+        SDL_UnlockMutex(batch->callback_lock);
+
+        if (!proceed)
+        {
+            GleedStopWorkerPool(pool);
+        }
+    }
+
+    return true;
+}
+
+static bool GleedInitRangeWorker(GleedWorkerPool *pool, void *data)
+{
+    GleedRangeBatch *batch = (GleedRangeBatch *)pool->userdata;
+    GleedRangeWorker *worker = (GleedRangeWorker *)data;
+    GleedMovie *movie = batch->movie;
+
+    worker->decoder = GleedCreateVPXDecoder(movie->video_codec);
+
+    if (!worker->decoder)
+        return false;
+
+    GleedSetVPXDecoderQuality(worker->decoder, batch->quality);
+
+    int w, h;
+    GleedGetVideoOutputSize(movie, &w, &h);
+
+    worker->surface = GleedCreateVideoFrameSurface(movie, w, h);
+
+    return worker->surface != NULL;
+}
+
+static void GleedCleanupRangeWorker(GleedWorkerPool *pool, void *data)
+{
+    GleedRangeWorker *worker = (GleedRangeWorker *)data;
+
+    GleedDestroyVPXDecoder(worker->decoder);
+    GleedDestroyVPXDecoder(worker->alpha_decoder);
+    SDL_DestroySurface(worker->surface);
+    SDL_free(worker->data);
+    SDL_free(worker->alpha_data);
+}
+
+bool GleedDecodeRange(GleedMovie *movie, Uint32 first, Uint32 last, GleedDecodeRangeCallback callback, void *userdata)
+{
+    if (!movie || !callback)
+        return GleedSetError("Invalid arguments");
+
+    if (!GleedCanPlaybackVideo(movie))
+        return GleedSetError("No video track selected");
+
+    if (movie->video_codec != GLEED_CODEC_TYPE_VP8 && movie->video_codec != GLEED_CODEC_TYPE_VP9)
+        return GleedSetError("Unsupported video codec");
+
+    if (first > last || last >= movie->total_frames)
+        return GleedSetError("Invalid frame range %u..%u, movie has %u frames", first, last, movie->total_frames);
+
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    const Uint32 start = GleedFindVideoKeyFrame(movie, first);
+
+    int group_count = 0;
+
+    for (Uint32 frame = start; frame <= last; frame++)
+    {
+        if (frame == start || frames[frame].key_frame)
+            group_count++;
+    }
+
+    GleedRangeGroup *groups = (GleedRangeGroup *)SDL_malloc(group_count * sizeof(GleedRangeGroup));
+
+    if (!groups)
+        return GleedSetError("Failed to allocate memory for range decoding");
+
+    /* Every keyframe resets all decoder references, so each group decodes independently of the others */
+    int group = -1;
+
+    for (Uint32 frame = start; frame <= last; frame++)
+    {
+        if (frame == start || frames[frame].key_frame)
+        {
+            groups[++group].key_frame = frame;
+        }
+
+        groups[group].end = frame + 1;
+    }
+
+    GleedRangeBatch batch;
+    SDL_zero(batch);
+
+    batch.movie = movie;
+    batch.first = first;
+    batch.groups = groups;
+    batch.callback = callback;
+    batch.userdata = userdata;
+    batch.callback_lock = SDL_CreateMutex();
+
+    if (!batch.callback_lock)
+    {
+        SDL_free(groups);
+        return GleedSetError("Failed to create range decoding lock: %s", SDL_GetError());
+    }
+
+    batch.color = GleedAcquireVideoColorTransform(movie);
+    batch.quality = GleedGetVideoDecodeQuality(movie);
+
+    GleedWorkerPool pool;
+    SDL_zero(pool);
+
+    pool.name = "GleedRangeWorker";
+    pool.max_threads = GLEED_RANGE_MAX_THREADS;
+    pool.job_count = group_count;
+    pool.worker_size = sizeof(GleedRangeWorker);
+    pool.init = GleedInitRangeWorker;
+    pool.run = GleedDecodeRangeGroup;
+    pool.cleanup = GleedCleanupRangeWorker;
+    pool.userdata = &batch;
+
+    const bool success = GleedRunWorkerPool(&pool);
+
+    GleedReleaseColorTransform(batch.color);
+    SDL_DestroyMutex(batch.callback_lock);
+    SDL_free(groups);
+
+    return success;
+}
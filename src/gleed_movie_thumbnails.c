@@ -0,0 +1,228 @@
+#include "gleed_movie_internal.h"
+
+/* More decoders than that only fight over the IO lock */
+#define GLEED_THUMBNAIL_MAX_THREADS 8
+
+typedef struct
+{
+    GleedMovie *movie;
+
+    const Uint32 *key_frames; /**< Keyframe decoded for each thumbnail */
+    const int *jobs;          /**< Thumbnails to decode, one per distinct keyframe */
+
+    SDL_Surface **surfaces; /**< Output surfaces, one per thumbnail */
+} GleedThumbnailBatch;
+
+typedef struct
+{
+    GleedVPXDecoder *decoder; /**< Every job starts at a keyframe, which resets all decoder references, so one decoder serves them all */
+    Uint8 *data;              /**< Packet buffer */
+    Uint32 data_size;         /**< Capacity of the packet buffer */
+} GleedThumbnailWorker;
+
+/*
+    Decodes from the keyframe until the decoder shows an image. That is the keyframe itself,
+    unless it is a hidden one (VP9 superframe with an alt-ref), then the next frame or two.
+*/
+static bool GleedDecodeThumbnail(GleedThumbnailBatch *batch, GleedVPXDecoder *decoder, Uint8 **data, Uint32 *data_size, Uint32 key_frame, SDL_Surface *surface)
+{
+    GleedMovie *movie = batch->movie;
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    for (Uint32 frame = key_frame; frame < movie->total_frames; frame++)
+    {
+        const CachedMovieFrame *cached_frame = &frames[frame];
+
+        if (!GleedReadVideoPacket(movie, frame, data, data_size))
+            return false;
+
+        GleedVideoFrameYUV yuv;
+        bool shown;
+
+        if (!GleedDecodeVPXPacket(decoder, *data, cached_frame->size, frame, &yuv, &shown))
+            return false;
+
+        if (shown)
+        {
+            /* Thumbnails are small, filtered scaling is what keeps them from aliasing */
+            GleedConvertParams params = {&movie->video_crop, false, false, false, NULL};
+
+            return GleedConvertYUVFrame(&yuv, NULL, &params, surface);
+        }
+    }
+
+    return GleedSetError("No displayable frame after keyframe %u", key_frame);
+}
+
+static bool GleedInitThumbnailWorker(GleedWorkerPool *pool, void *data)
+{
+    GleedThumbnailBatch *batch = (GleedThumbnailBatch *)pool->userdata;
+    GleedThumbnailWorker *worker = (GleedThumbnailWorker *)data;
+
+    worker->decoder = GleedCreateVPXDecoder(batch->movie->video_codec);
+
+    return worker->decoder != NULL;
+}
+
+static bool GleedRunThumbnailJob(GleedWorkerPool *pool, void *data, int job)
+{
+    GleedThumbnailBatch *batch = (GleedThumbnailBatch *)pool->userdata;
+    GleedThumbnailWorker *worker = (GleedThumbnailWorker *)data;
+
+    const int thumbnail = batch->jobs[job];
+
+    return GleedDecodeThumbnail(batch, worker->decoder, &worker->data, &worker->data_size, batch->key_frames[thumbnail], batch->surfaces[thumbnail]);
+}
+
+static void GleedCleanupThumbnailWorker(GleedWorkerPool *pool, void *data)
+{
+    GleedThumbnailWorker *worker = (GleedThumbnailWorker *)data;
+
+    GleedDestroyVPXDecoder(worker->decoder);
+    SDL_free(worker->data);
+}
+
+/* Keyframe closest in time to the given frame, in either direction */
+static Uint32 GleedFindNearestVideoKeyFrame(GleedMovie *movie, Uint32 frame)
+{
+    const CachedMovieFrame *frames = movie->cached_frames[movie->current_video_track];
+
+    const Uint32 previous = GleedFindVideoKeyFrame(movie, frame);
+
+    Uint32 next = frame + 1;
+
+    while (next < movie->total_frames && !frames[next].key_frame)
+    {
+        next++;
+    }
+
+    if (next >= movie->total_frames)
+        return previous;
+
+    const Uint64 timecode = frames[frame].timecode;
+
+    return frames[next].timecode - timecode < timecode - frames[previous].timecode ? next : previous;
+}
+
+static void GleedDestroyThumbnails(SDL_Surface **surfaces, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        SDL_DestroySurface(surfaces[i]);
+        surfaces[i] = NULL;
+    }
+}
+
+bool GleedExtractThumbnails(GleedMovie *movie, const Uint64 *times_ms, int count, int w, int h, SDL_Surface **out_surfaces)
+{
+    if (!movie || !times_ms || !out_surfaces || count <= 0)
+        return GleedSetError("Invalid arguments");
+
+    if (w <= 0 || h <= 0)
+        return GleedSetError("Invalid thumbnail size %dx%d", w, h);
+
+    if (!GleedCanPlaybackVideo(movie))
+        return GleedSetError("No video track selected");
+
+    if (movie->video_codec != GLEED_CODEC_TYPE_VP8 && movie->video_codec != GLEED_CODEC_TYPE_VP9)
+        return GleedSetError("Unsupported video codec");
+
+    SDL_memset(out_surfaces, 0, count * sizeof(SDL_Surface *));
+
+    Uint32 *key_frames = (Uint32 *)SDL_malloc(count * sizeof(Uint32));
+    int *jobs = (int *)SDL_malloc(count * sizeof(int));
+    int *sources = (int *)SDL_malloc(count * sizeof(int));
+
+    if (!key_frames || !jobs || !sources)
+    {
+        SDL_free(key_frames);
+        SDL_free(jobs);
+        SDL_free(sources);
+        return GleedSetError("Failed to allocate memory for thumbnails");
+    }
+
+    /* Times falling into the same group of pictures share one decoded keyframe */
+    int job_count = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const Uint32 frame = GleedFindFrameAtTimecode(movie, movie->current_video_track, GleedMillisecondsToTimecode(movie, times_ms[i]));
+
+        key_frames[i] = GleedFindNearestVideoKeyFrame(movie, SDL_min(frame, movie->total_frames - 1));
+        sources[i] = i;
+
+        for (int j = 0; j < i; j++)
+        {
+            if (key_frames[j] == key_frames[i])
+            {
+                sources[i] = j;
+                break;
+            }
+        }
+
+        if (sources[i] == i)
+        {
+            jobs[job_count++] = i;
+        }
+    }
+
+    bool success = true;
+
+    for (int i = 0; i < count && success; i++)
+    {
+        if (sources[i] != i)
+            continue;
+
+        out_surfaces[i] = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_RGB24);
+
+        if (!out_surfaces[i])
+            success = GleedSetError("Failed to create thumbnail surface: %s", SDL_GetError());
+    }
+
+    if (success)
+    {
+        GleedThumbnailBatch batch;
+        SDL_zero(batch);
+
+        batch.movie = movie;
+        batch.key_frames = key_frames;
+        batch.jobs = jobs;
+        batch.surfaces = out_surfaces;
+
+        GleedWorkerPool pool;
+        SDL_zero(pool);
+
+        pool.name = "GleedThumbnailWorker";
+        pool.max_threads = GLEED_THUMBNAIL_MAX_THREADS;
+        pool.job_count = job_count;
+        pool.worker_size = sizeof(GleedThumbnailWorker);
+        pool.init = GleedInitThumbnailWorker;
+        pool.run = GleedRunThumbnailJob;
+        pool.cleanup = GleedCleanupThumbnailWorker;
+        pool.userdata = &batch;
+
+        success = GleedRunWorkerPool(&pool);
+    }
+
+    for (int i = 0; i < count && success; i++)
+    {
+        if (sources[i] == i)
+            continue;
+
+        out_surfaces[i] = SDL_DuplicateSurface(out_surfaces[sources[i]]);
+
+        if (!out_surfaces[i])
+            success = GleedSetError("Failed to create thumbnail surface: %s", SDL_GetError());
+    }
+
+    if (!success)
+    {
+        GleedDestroyThumbnails(out_surfaces, count);
+    }
+
+    SDL_free(key_frames);
+    SDL_free(jobs);
+    SDL_free(sources);
+
+    return success;
+}
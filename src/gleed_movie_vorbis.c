@@ -10,8 +10,27 @@ typedef struct
     vorbis_block vb;
 
     int packet_no;
+    Uint64 pool_key; /**< Decoder pool key of the headers the context was set up from */
 } VorbisContext;
 
+/* Vorbis decoder is set up from the codebooks in the headers, so only tracks with identical headers can share one */
+static Uint64 GleedGetVorbisPoolKey(const GleedMovieTrack *audio_track)
+{
+    return GleedHashBytes(GLEED_HASH_INIT, audio_track->codec_private_data, audio_track->codec_private_size);
+}
+
+static void GleedDestroyVorbisContext(void *context)
+{
+    VorbisContext *ctx = (VorbisContext *)context;
+
+    vorbis_block_clear(&ctx->vb);
+    vorbis_dsp_clear(&ctx->vd);
+    vorbis_comment_clear(&ctx->vc);
+    vorbis_info_clear(&ctx->vi);
+
+    SDL_free(ctx);
+}
+
 static bool GleedInitVorbis(GleedMovie *movie)
 {
     GleedMovieTrack *audio_track = GleedGetAudioTrack(movie);
@@ -97,6 +116,8 @@ static bool GleedInitVorbis(GleedMovie *movie)
         return GleedSetError("Failed to initialize Vorbis block: %d", block_error);
     }
 
+    ctx->pool_key = GleedGetVorbisPoolKey(audio_track);
+
     movie->vorbis_context = ctx;
 
     return true;
@@ -106,6 +127,11 @@ VorbisDecodeResult GleedDecode_Vorbis(GleedMovie *movie)
 {
     GleedMovieTrack *audio_track = GleedGetAudioTrack(movie);
 
+    if (!movie->vorbis_context && audio_track->codec_private_data)
+    {
+        movie->vorbis_context = GleedTakePooledDecoder(GLEED_POOLED_DECODER_VORBIS, GleedGetVorbisPoolKey(audio_track));
+    }
+
     if (!movie->vorbis_context)
     {
         if (!GleedInitVorbis(movie))
@@ -180,12 +206,27 @@ VorbisDecodeResult GleedDecode_Vorbis(GleedMovie *movie)
     return GLEED_VORBIS_DECODE_DONE;
 }
 
+void GleedResetVorbis(GleedMovie *movie)
+{
+    if (movie->vorbis_context)
+    {
+        VorbisContext *ctx = (VorbisContext *)movie->vorbis_context;
+
+        /* Drops the overlap of the previous packet, so the first packet after a seek produces no samples */
+        vorbis_synthesis_restart(&ctx->vd);
+    }
+}
+
 void GleedCloseVorbis(GleedMovie *movie)
 {
     if (movie->vorbis_context)
     {
         VorbisContext *ctx = (VorbisContext *)movie->vorbis_context;
-        SDL_free(movie->vorbis_context);
+
+        vorbis_synthesis_restart(&ctx->vd);
+        ctx->packet_no = 0;
+
+        GleedParkPooledDecoder(GLEED_POOLED_DECODER_VORBIS, ctx->pool_key, ctx, GleedDestroyVorbisContext);
         movie->vorbis_context = NULL;
     }
 }
\ No newline at end of file
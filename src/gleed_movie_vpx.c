@@ -3,12 +3,41 @@
 #include <vpx/vpx_decoder.h>
 #include <vpx/vp8dx.h>
 
+/*
+    Alpha stream is decoded by a second decoder on its own thread, while the colour stream is decoded on the caller's.
+    Semaphores hand a single packet over and back, so the fields below are never touched by both threads at once.
+*/
+typedef struct
+{
+    GleedVPXDecoder *decoder;
+    SDL_Thread *thread;
+    SDL_Semaphore *start; /**< Signalled when a packet is ready to decode, or to quit */
+    SDL_Semaphore *done;  /**< Signalled when the packet has been decoded */
+
+    const Uint8 *packet;
+    Uint32 packet_size;
+    Uint32 frame;
+    bool quit;
+
+    bool failed;
+    bool shown;
+    GleedVideoFrameYUV yuv;
+    char error[256];
+} VPXAlphaWorker;
+
 typedef struct
 {
     vpx_codec_iface_t *vp8;
     vpx_codec_iface_t *vp9;
     vpx_codec_ctx_t codec8;
     vpx_codec_ctx_t codec9;
+
+    GleedFrameBufferPool *frame_pool; /**< Decoded frames live here (VP9), acquired frames are copied here (VP8) */
+    vpx_image_t *last_image;          /**< Last image returned by the decoder, valid until the next decode call */
+    GleedVideoFrameYUV *last_alpha;   /**< Alpha image decoded along with last_image, NULL if it has none */
+    Uint64 last_decode_ns;            /**< Time spent decoding last_image, conversion adds to it */
+    VPXAlphaWorker *alpha;            /**< Alpha decoder, created with the first frame carrying alpha */
+    int applied_quality;              /**< GleedVideoDecodeQuality the decoders are currently set up for, -1 if none yet */
 } VPXContext;
 
 /* Stolen from libvpx/tools_common.c */
@@ -28,47 +57,557 @@ static int vpx_img_plane_height(const vpx_image_t *img, int plane)
         return img->d_h;
 }
 
-static SDL_PixelFormat vpx_format_to_sdl_format(vpx_img_fmt_t fmt)
+static SDL_Colorspace vpx_cs_to_sdl_cs(vpx_color_space_t cs, vpx_color_range_t range)
 {
-    switch (fmt)
+    const bool full_range = range == VPX_CR_FULL_RANGE;
+
+    switch (cs)
     {
-    case VPX_IMG_FMT_NONE:
-        return SDL_PIXELFORMAT_UNKNOWN;
-    case VPX_IMG_FMT_YV12:
-        return SDL_PIXELFORMAT_YV12;
-    case VPX_IMG_FMT_I420:
-        return SDL_PIXELFORMAT_IYUV;
-    case VPX_IMG_FMT_I422:
-        return SDL_PIXELFORMAT_YVYU;
+    case VPX_CS_BT_2020:
+        return full_range ? SDL_COLORSPACE_BT2020_FULL : SDL_COLORSPACE_BT2020_LIMITED;
+    case VPX_CS_BT_709:
+        return full_range ? SDL_COLORSPACE_BT709_FULL : SDL_COLORSPACE_BT709_LIMITED;
     default:
-        return SDL_PIXELFORMAT_YV12;
+        /* Unknown colorspace is treated as BT.601, which is what VP8 always uses */
+        return full_range ? SDL_COLORSPACE_BT601_FULL : SDL_COLORSPACE_BT601_LIMITED;
     }
 }
 
-static SDL_Colorspace vpx_cs_to_sdl_cs(vpx_color_space_t cs)
+/* Describes decoder image planes without copying them */
+static void vpx_img_to_yuv_frame(const vpx_image_t *img, GleedVideoFrameYUV *frame)
 {
-    switch (cs)
+    frame->w = img->d_w;
+    frame->h = img->d_h;
+    frame->chroma_shift_x = img->x_chroma_shift;
+    frame->chroma_shift_y = img->y_chroma_shift;
+    frame->bit_depth = img->bit_depth;
+    frame->colorspace = vpx_cs_to_sdl_cs(img->cs, img->range);
+    frame->frame = (Uint32)(uintptr_t)img->user_priv;
+
+    for (int plane = 0; plane < 3; plane++)
     {
-    case VPX_CS_BT_2020:
-        return SDL_COLORSPACE_BT2020_FULL;
-    case VPX_CS_BT_601:
-        return SDL_COLORSPACE_BT601_FULL;
-    case VPX_CS_BT_709:
-        return SDL_COLORSPACE_BT709_FULL;
-    case VPX_CS_SRGB:
-        return SDL_COLORSPACE_SRGB;
-    default:
-        return SDL_COLORSPACE_YUV_DEFAULT;
+        frame->planes[plane] = img->planes[plane];
+        frame->pitches[plane] = img->stride[plane];
+    }
+}
+
+/*
+    Worst case size of a 4:2:0 frame buffer libvpx asks for at the track size:
+    planes are padded by a border on every side and rows are aligned.
+*/
+static size_t vpx_estimate_frame_buffer_size(int w, int h)
+{
+    const int border = 160;
+    const int aligned_w = ((w + 31) & ~31) + 2 * border;
+    const int aligned_h = ((h + 31) & ~31) + 2 * border;
+
+    const size_t luma_size = (size_t)aligned_w * aligned_h;
+
+    return luma_size + luma_size / 2 + 64;
+}
+
+static int vpx_get_frame_buffer(void *priv, size_t min_size, vpx_codec_frame_buffer_t *fb)
+{
+    GleedFrameBuffer *buffer = GleedGetFrameBuffer((GleedFrameBufferPool *)priv, min_size);
+
+    if (!buffer)
+        return -1;
+
+    fb->data = buffer->data;
+    fb->size = buffer->size;
+    fb->priv = buffer;
+
+    return 0;
+}
+
+static int vpx_release_frame_buffer(void *priv, vpx_codec_frame_buffer_t *fb)
+{
+    GleedReleaseFrameBuffer((GleedFrameBuffer *)fb->priv);
+
+    return 0;
+}
+
+/* MSB-first bit reader for uncompressed VP9 frame headers */
+typedef struct
+{
+    const Uint8 *data;
+    size_t size;
+    size_t bit;
+    bool overrun;
+} VPXBitReader;
+
+static Uint32 vpx_read_bits(VPXBitReader *br, int count)
+{
+    Uint32 value = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        Uint32 bit = 0;
+
+        if (br->bit < br->size * 8)
+        {
+            bit = (br->data[br->bit >> 3] >> (7 - (br->bit & 7))) & 1;
+        }
+        else
+        {
+            br->overrun = true;
+        }
+
+        value = (value << 1) | bit;
+        br->bit++;
+    }
+
+    return value;
+}
+
+/* VP8 boolean entropy decoder, as described in RFC 6386 section 7 */
+typedef struct
+{
+    const Uint8 *data;
+    const Uint8 *end;
+    Uint32 value;
+    Uint32 range;
+    int bit_count;
+} VP8BoolDecoder;
+
+static void vp8_bool_init(VP8BoolDecoder *bd, const Uint8 *data, size_t size)
+{
+    bd->data = data;
+    bd->end = data + size;
+    bd->value = 0;
+    bd->range = 255;
+    bd->bit_count = 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        bd->value = (bd->value << 8) | (bd->data < bd->end ? *bd->data++ : 0);
+    }
+}
+
+static int vp8_bool_read(VP8BoolDecoder *bd, int probability)
+{
+    const Uint32 split = 1 + (((bd->range - 1) * probability) >> 8);
+    const Uint32 big_split = split << 8;
+    int bit;
+
+    if (bd->value >= big_split)
+    {
+        bit = 1;
+        bd->range -= split;
+        bd->value -= big_split;
+    }
+    else
+    {
+        bit = 0;
+        bd->range = split;
     }
+
+    while (bd->range < 128)
+    {
+        bd->value <<= 1;
+        bd->range <<= 1;
+
+        if (++bd->bit_count == 8)
+        {
+            bd->bit_count = 0;
+            bd->value |= bd->data < bd->end ? *bd->data++ : 0;
+        }
+    }
+
+    return bit;
+}
+
+static Uint32 vp8_bool_literal(VP8BoolDecoder *bd, int bits)
+{
+    Uint32 value = 0;
+
+    while (bits--)
+    {
+        value = (value << 1) | vp8_bool_read(bd, 128);
+    }
+
+    return value;
+}
+
+/* Skips optional signed delta: flag, magnitude and sign. Returns the flag. */
+static int vp8_bool_skip_delta(VP8BoolDecoder *bd, int magnitude_bits)
+{
+    if (!vp8_bool_read(bd, 128))
+        return 0;
+
+    vp8_bool_literal(bd, magnitude_bits + 1);
+    return 1;
 }
 
-bool GleedDecodeVPX(GleedMovie *movie)
+/*
+    VP8 frame is droppable if it's an inter frame that refreshes no reference buffers
+    and leaves no persistent state behind (entropy contexts, segmentation, loop filter deltas).
+
+    Those flags live in the bool-coded first partition, RFC 6386 section 19.2
+*/
+static bool GleedIsVP8FrameDroppable(const Uint8 *data, size_t size)
 {
-    Uint64 decode_start = SDL_GetTicks();
+    if (size < 3)
+        return false;
+
+    const Uint32 frame_tag = data[0] | (data[1] << 8) | (data[2] << 16);
+    const bool key_frame = !(frame_tag & 1);
+    const Uint32 first_partition_size = frame_tag >> 5;
+
+    if (key_frame || first_partition_size > size - 3)
+        return false;
+
+    VP8BoolDecoder bd;
+    vp8_bool_init(&bd, data + 3, first_partition_size);
+
+    /* segmentation_enabled, segment map and features persist between frames */
+    if (vp8_bool_read(&bd, 128))
+        return false;
+
+    vp8_bool_literal(&bd, 1 + 6 + 3); /* filter_type, loop_filter_level, sharpness_level */
+
+    /* loop_filter_adj_enable, then mode_ref_lf_delta_update: deltas persist too */
+    if (vp8_bool_read(&bd, 128) && vp8_bool_read(&bd, 128))
+        return false;
+
+    vp8_bool_literal(&bd, 2); /* log2_nbr_of_dct_partitions */
+
+    vp8_bool_literal(&bd, 7); /* y_ac_qi */
+
+    for (int i = 0; i < 5; i++)
+    {
+        vp8_bool_skip_delta(&bd, 4);
+    }
+
+    const int refresh_golden_frame = vp8_bool_read(&bd, 128);
+    const int refresh_alternate_frame = vp8_bool_read(&bd, 128);
+
+    if (refresh_golden_frame || refresh_alternate_frame)
+        return false;
+
+    const Uint32 copy_buffer_to_golden = vp8_bool_literal(&bd, 2);
+    const Uint32 copy_buffer_to_alternate = vp8_bool_literal(&bd, 2);
+
+    if (copy_buffer_to_golden || copy_buffer_to_alternate)
+        return false;
+
+    vp8_bool_literal(&bd, 2); /* sign_bias_golden, sign_bias_alternate */
+
+    const int refresh_entropy_probs = vp8_bool_read(&bd, 128);
+    const int refresh_last = vp8_bool_read(&bd, 128);
+
+    return !refresh_entropy_probs && !refresh_last;
+}
+
+/*
+    Checks whether next VP9 frame would read motion vectors of the previous decoded frame.
+    Only key, intra-only and error resilient frames are guaranteed not to do so.
+*/
+static bool GleedIsVP9FrameIndependent(const Uint8 *data, size_t size)
+{
+    VPXBitReader br = {data, size, 0, false};
+
+    if (vpx_read_bits(&br, 2) != 2)
+        return false;
+
+    const Uint32 profile_low_bit = vpx_read_bits(&br, 1);
+    const Uint32 profile = profile_low_bit | (vpx_read_bits(&br, 1) << 1);
+
+    if (profile == 3)
+        vpx_read_bits(&br, 1);
+
+    if (vpx_read_bits(&br, 1)) /* show_existing_frame */
+        return false;
+
+    const Uint32 frame_type = vpx_read_bits(&br, 1);
+    const Uint32 show_frame = vpx_read_bits(&br, 1);
+    const Uint32 error_resilient_mode = vpx_read_bits(&br, 1);
+    const Uint32 intra_only = show_frame ? 0 : vpx_read_bits(&br, 1);
+
+    return !br.overrun && (frame_type == 0 || error_resilient_mode || intra_only);
+}
+
+/*
+    VP9 frame is droppable if it's a non-reference inter frame which keeps no persistent state
+    (uncompressed header, VP9 bitstream spec section 6.2).
+
+    Unlike VP8, every decoded VP9 frame becomes "previous frame" for motion vector prediction,
+    so the next frame must not depend on it either.
+*/
+static bool GleedIsVP9FrameDroppable(const Uint8 *data, size_t size, const Uint8 *next_data, size_t next_size)
+{
+    if (size == 0)
+        return false;
+
+    /* Superframes bundle hidden reference frames, never drop them */
+    const Uint8 marker = data[size - 1];
+    if ((marker & 0xe0) == 0xc0)
+        return false;
+
+    VPXBitReader br = {data, size, 0, false};
+
+    if (vpx_read_bits(&br, 2) != 2)
+        return false;
+
+    const Uint32 profile_low_bit = vpx_read_bits(&br, 1);
+    const Uint32 profile = profile_low_bit | (vpx_read_bits(&br, 1) << 1);
+
+    if (profile == 3)
+        vpx_read_bits(&br, 1);
+
+    /* show_existing_frame only presents a reference buffer, decoder state is untouched */
+    if (vpx_read_bits(&br, 1))
+        return !br.overrun;
+
+    const Uint32 frame_type = vpx_read_bits(&br, 1);
+    const Uint32 show_frame = vpx_read_bits(&br, 1);
+    const Uint32 error_resilient_mode = vpx_read_bits(&br, 1);
+
+    /* Error resilient frames reset saved probability contexts */
+    if (frame_type == 0 || error_resilient_mode)
+        return false;
+
+    if (!show_frame && vpx_read_bits(&br, 1)) /* intra_only */
+        return false;
+
+    vpx_read_bits(&br, 2); /* reset_frame_context */
+
+    if (vpx_read_bits(&br, 8) != 0) /* refresh_frame_flags */
+        return false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        vpx_read_bits(&br, 3 + 1); /* ref_frame_idx, ref_frame_sign_bias */
+    }
+
+    bool found_ref = false;
+
+    for (int i = 0; i < 3 && !found_ref; i++)
+    {
+        found_ref = vpx_read_bits(&br, 1);
+    }
+
+    if (!found_ref)
+        vpx_read_bits(&br, 32); /* frame_width_minus_1, frame_height_minus_1 */
+
+    if (vpx_read_bits(&br, 1)) /* render_and_frame_size_different */
+        vpx_read_bits(&br, 32);
+
+    vpx_read_bits(&br, 1); /* allow_high_precision_mv */
+
+    if (!vpx_read_bits(&br, 1)) /* is_filter_switchable */
+        vpx_read_bits(&br, 2);
+
+    if (vpx_read_bits(&br, 1)) /* refresh_frame_context */
+        return false;
+
+    vpx_read_bits(&br, 1 + 2); /* frame_parallel_decoding_mode, frame_context_idx */
+
+    vpx_read_bits(&br, 6 + 3); /* filter_level, sharpness */
+
+    /* mode_ref_delta_enabled, then mode_ref_delta_update: deltas persist */
+    if (vpx_read_bits(&br, 1) && vpx_read_bits(&br, 1))
+        return false;
+
+    vpx_read_bits(&br, 8); /* base_q_idx */
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (vpx_read_bits(&br, 1))
+            vpx_read_bits(&br, 5);
+    }
+
+    /* segmentation_enabled: segmentation map is carried over to next frames */
+    if (vpx_read_bits(&br, 1))
+        return false;
+
+    if (br.overrun)
+        return false;
+
+    return next_data && GleedIsVP9FrameIndependent(next_data, next_size);
+}
+
+bool GleedIsVPXFrameDroppable(GleedMovieCodecType codec, const Uint8 *data, size_t size, const Uint8 *next_data, size_t next_size)
+{
+    if (!data)
+        return false;
+
+    if (codec == GLEED_CODEC_TYPE_VP8)
+    {
+        return GleedIsVP8FrameDroppable(data, size);
+    }
+    else if (codec == GLEED_CODEC_TYPE_VP9)
+    {
+        return GleedIsVP9FrameDroppable(data, size, next_data, next_size);
+    }
+
+    return false;
+}
+
+/*
+    Keyframes reset all reference buffers, so decoding may start from them.
+    Only the first byte of the frame is inspected, which lets the parser check frames
+    in Block elements (those carry no keyframe flag) without reading them whole.
+*/
+bool GleedIsVPXKeyFrame(GleedMovieCodecType codec, const Uint8 *data, size_t size)
+{
+    if (!data || size == 0)
+        return false;
+
+    if (codec == GLEED_CODEC_TYPE_VP8)
+    {
+        return !(data[0] & 1);
+    }
+    else if (codec == GLEED_CODEC_TYPE_VP9)
+    {
+        VPXBitReader br = {data, size, 0, false};
+
+        if (vpx_read_bits(&br, 2) != 2)
+            return false;
+
+        const Uint32 profile_low_bit = vpx_read_bits(&br, 1);
+        const Uint32 profile = profile_low_bit | (vpx_read_bits(&br, 1) << 1);
+
+        if (profile == 3)
+            vpx_read_bits(&br, 1);
+
+        if (vpx_read_bits(&br, 1)) /* show_existing_frame */
+            return false;
+
+        const Uint32 frame_type = vpx_read_bits(&br, 1);
+
+        return !br.overrun && frame_type == 0;
+    }
+
+    return false;
+}
+
+static int VPXAlphaWorkerThread(void *data)
+{
+    VPXAlphaWorker *worker = (VPXAlphaWorker *)data;
+
+    for (;;)
+    {
+        SDL_WaitSemaphore(worker->start);
+
+        if (worker->quit)
+            break;
+
+        worker->failed = !GleedDecodeVPXPacket(worker->decoder, worker->packet, worker->packet_size, worker->frame, &worker->yuv, &worker->shown);
+
+        if (worker->failed)
+        {
+            SDL_strlcpy(worker->error, GleedGetError(), sizeof(worker->error));
+        }
+
+        SDL_SignalSemaphore(worker->done);
+    }
+
+    return 0;
+}
+
+static void VPXDestroyAlphaWorker(VPXAlphaWorker *worker)
+{
+    if (!worker)
+        return;
+
+    if (worker->thread)
+    {
+        worker->quit = true;
+        SDL_SignalSemaphore(worker->start);
+        SDL_WaitThread(worker->thread, NULL);
+    }
+
+    if (worker->start)
+        SDL_DestroySemaphore(worker->start);
+
+    if (worker->done)
+        SDL_DestroySemaphore(worker->done);
+
+    GleedDestroyVPXDecoder(worker->decoder);
+    SDL_free(worker);
+}
+
+static VPXAlphaWorker *VPXCreateAlphaWorker(GleedMovieCodecType codec)
+{
+    VPXAlphaWorker *worker = (VPXAlphaWorker *)SDL_calloc(1, sizeof(VPXAlphaWorker));
+
+    if (!worker)
+    {
+        GleedSetError("Failed to allocate memory for alpha decoder");
+        return NULL;
+    }
+
+    worker->decoder = GleedCreateVPXDecoder(codec);
+
+    if (!worker->decoder)
+    {
+        SDL_free(worker);
+        return NULL;
+    }
+
+    worker->start = SDL_CreateSemaphore(0);
+    worker->done = SDL_CreateSemaphore(0);
+
+    if (!worker->start || !worker->done)
+    {
+        GleedSetError("Failed to create alpha decoder semaphores: %s", SDL_GetError());
+        VPXDestroyAlphaWorker(worker);
+        return NULL;
+    }
+
+    worker->thread = SDL_CreateThread(VPXAlphaWorkerThread, "GleedAlphaDecoder", worker);
+
+    if (!worker->thread)
+    {
+        GleedSetError("Failed to create alpha decoder thread: %s", SDL_GetError());
+        VPXDestroyAlphaWorker(worker);
+        return NULL;
+    }
+
+    return worker;
+}
+
+/* Keeps decoder controls in sync with the quality snapshot of the frame being decoded */
+static void VPXApplyQuality(GleedMovie *movie, VPXContext *ctx)
+{
+    if (ctx->applied_quality == (int)movie->frame_quality)
+        return;
+
+    /* libvpx has no deblocking control for VP8 */
+    if (ctx->vp9)
+    {
+        vpx_codec_control(&ctx->codec9, VP9_SET_SKIP_LOOP_FILTER, movie->frame_quality >= GLEED_VIDEO_QUALITY_FASTEST);
+    }
+
+    if (ctx->alpha)
+    {
+        GleedSetVPXDecoderQuality(ctx->alpha->decoder, movie->frame_quality);
+    }
+
+    ctx->applied_quality = movie->frame_quality;
+}
+
+bool GleedDecodeVPX(GleedMovie *movie, SDL_Surface *target, GleedVideoDecodeFlags flags)
+{
+    const Uint64 decode_start = SDL_GetTicksNS();
+
+    if (!movie->vpx_context)
+    {
+        /* Context parked by a freed movie comes with initialized decoders and allocated frame buffers */
+        movie->vpx_context = GleedTakePooledDecoder(GLEED_POOLED_DECODER_VPX, movie->video_codec);
+    }
 
     if (!movie->vpx_context)
     {
         movie->vpx_context = SDL_calloc(1, sizeof(VPXContext));
+
+        if (!movie->vpx_context)
+        {
+            return GleedSetError("Failed to allocate memory for VPX context");
+        }
+
+        ((VPXContext *)movie->vpx_context)->applied_quality = -1;
     }
 
     vpx_codec_iface_t *vpi = NULL;
@@ -76,6 +615,18 @@ bool GleedDecodeVPX(GleedMovie *movie)
 
     VPXContext *ctx = (VPXContext *)movie->vpx_context;
 
+    if (!ctx->frame_pool)
+    {
+        GleedMovieTrack *video_track = GleedGetVideoTrack(movie);
+
+        ctx->frame_pool = GleedCreateFrameBufferPool(vpx_estimate_frame_buffer_size(video_track->video_width, video_track->video_height));
+
+        if (!ctx->frame_pool)
+        {
+            return false;
+        }
+    }
+
     if (movie->video_codec == GLEED_CODEC_TYPE_VP8)
     {
         if (!ctx->vp8)
@@ -105,6 +656,14 @@ bool GleedDecodeVPX(GleedMovie *movie)
             {
                 return GleedSetError("Failed to initialize VP9 decoder: %s", vpx_codec_err_to_string(vp9_err));
             }
+
+            /* VP9 decodes straight into our pooled buffers, VP8 does not support external ones */
+            vp9_err = vpx_codec_set_frame_buffer_functions(&ctx->codec9, vpx_get_frame_buffer, vpx_release_frame_buffer, ctx->frame_pool);
+
+            if (vp9_err != VPX_CODEC_OK)
+            {
+                return GleedSetError("Failed to set VP9 frame buffer functions: %s", vpx_codec_err_to_string(vp9_err));
+            }
         }
 
         vpi = ctx->vp9;
@@ -116,119 +675,297 @@ bool GleedDecodeVPX(GleedMovie *movie)
         return GleedSetError("Failed to initialize VPX decoder");
     }
 
-    vpx_codec_err_t decode_err = vpx_codec_decode(codec, movie->encoded_video_frame, movie->encoded_video_frame_size, NULL, 0);
+    const CachedMovieFrame *cached_frame = GleedGetCurrentCachedFrame(movie, GLEED_TRACK_TYPE_VIDEO);
+    const bool has_alpha = cached_frame && cached_frame->alpha_size > 0;
+
+    if (has_alpha && !ctx->alpha)
+    {
+        ctx->alpha = VPXCreateAlphaWorker(movie->video_codec);
+
+        if (!ctx->alpha)
+        {
+            return false;
+        }
+
+        GleedSetVPXDecoderQuality(ctx->alpha->decoder, movie->frame_quality);
+    }
+
+    VPXApplyQuality(movie, ctx);
+
+    /* Alpha packet was read along with the colour one, its decoder runs while we decode the colour one */
+    if (has_alpha)
+    {
+        ctx->alpha->packet = movie->encoded_alpha_frame;
+        ctx->alpha->packet_size = cached_frame->alpha_size;
+        ctx->alpha->frame = movie->current_frame;
+        SDL_SignalSemaphore(ctx->alpha->start);
+    }
+
+    /* Image of the previous call is gone as soon as we feed the decoder again */
+    ctx->last_image = NULL;
+
+    /* Frame index travels with the packet, so any image libvpx gives back can be matched to its timecode */
+    vpx_codec_err_t decode_err = vpx_codec_decode(
+        codec,
+        movie->encoded_video_frame,
+        movie->encoded_video_frame_size,
+        (void *)(uintptr_t)movie->current_frame,
+        0);
+
+    if (has_alpha)
+    {
+        SDL_WaitSemaphore(ctx->alpha->done);
+    }
 
     if (decode_err != VPX_CODEC_OK)
     {
         return GleedSetError("Failed to decode VPX frame: %s, %s", vpx_codec_err_to_string(decode_err), vpx_codec_error_detail(codec));
     }
 
+    if (has_alpha && ctx->alpha->failed)
+    {
+        return GleedSetError("Failed to decode alpha: %s", ctx->alpha->error);
+    }
+
     vpx_codec_iter_t iter = NULL;
 
     vpx_image_t *img = NULL;
+    vpx_image_t *next_img = NULL;
+
+    /*
+        Drain the whole iterator, as libvpx expects us to. Only the last image is kept:
+        a VP9 superframe may contain a hidden frame followed by a shown one,
+        and we have exactly one presentation slot per packet anyway.
+    */
+    while ((next_img = vpx_codec_get_frame(codec, &iter)) != NULL)
+    {
+        img = next_img;
+    }
 
     /*
-        Boom! We do not query for more frames here, although we have a damn iterator!
-        TODO: Implement a way to query for more frames and queue them up for rendering.
+        Hidden frames (VP8 alt-refs, invisible blocks) only update decoder references
+        and produce no image - that's not an error, there is just nothing to show.
     */
-    img = vpx_codec_get_frame(codec, &iter);
+    movie->video_frame_shown = img != NULL;
 
-    if (!img)
+    movie->video_stats.decoded_frames++;
+
+    ctx->last_image = img;
+
+    /* Frames without an alpha payload, or with a hidden alpha frame, come out opaque */
+    ctx->last_alpha = has_alpha && ctx->alpha->shown ? &ctx->alpha->yuv : NULL;
+
+    ctx->last_decode_ns = SDL_GetTicksNS() - decode_start;
+
+    movie->video_stats.decode_ns += ctx->last_decode_ns;
+    movie->video_stats.quality_decoded_frames[movie->frame_quality]++;
+    movie->video_stats.quality_decode_ns[movie->frame_quality] += ctx->last_decode_ns;
+    movie->last_frame_decode_ns = ctx->last_decode_ns;
+    movie->last_frame_decode_ms = (Uint32)SDL_NS_TO_MS(movie->last_frame_decode_ns);
+
+    /* Caller converts the image itself, once it has a target for it */
+    if (!img || (flags & GLEED_VIDEO_DECODE_CONVERT_LATER))
     {
-        return GleedSetError("Failed to get decoded VPX frame - received no image");
+        return true;
     }
 
-    if (!movie->current_frame_surface)
+    /* Frame will never be displayed, codec state is all we needed */
+    if (!(flags & GLEED_VIDEO_DECODE_CONVERT))
     {
-        movie->current_frame_surface = SDL_CreateSurface(
-            img->d_w,
-            img->d_h,
-            SDL_PIXELFORMAT_RGB24);
+        movie->video_stats.skipped_conversions++;
+        return true;
     }
 
-    const SDL_PixelFormatDetails *rgb_format_details = SDL_GetPixelFormatDetails(
-        SDL_PIXELFORMAT_RGB24);
+    return GleedConvertVPX(movie, target);
+}
 
-    const SDL_PixelFormatDetails *vpx_format_details = SDL_GetPixelFormatDetails(
-        vpx_format_to_sdl_format(img->fmt));
+bool GleedConvertVPX(GleedMovie *movie, SDL_Surface *target)
+{
+    VPXContext *ctx = (VPXContext *)movie->vpx_context;
 
-    SDL_Colorspace vpx_colorspace = vpx_cs_to_sdl_cs(img->cs);
+    if (!ctx || !ctx->last_image)
+    {
+        return GleedSetError("No decoded video frame to convert");
+    }
 
-    size_t buffer_size = 0;
+    const Uint64 convert_start = SDL_GetTicksNS();
 
-    for (int plane = 0; plane < 3; plane++)
+    if (!target)
+    {
+        target = GleedEnsureVideoFrameSurface(movie);
+
+        if (!target)
+        {
+            return false;
+        }
+    }
+
+    GleedVideoFrameYUV frame;
+    vpx_img_to_yuv_frame(ctx->last_image, &frame);
+
+    GleedConvertParams params;
+    params.crop = &movie->video_crop;
+    params.premultiply = movie->video_premultiplied_alpha;
+    params.fast = movie->frame_quality >= GLEED_VIDEO_QUALITY_FAST;
+    /* Caller buffers (GleedDecodeVideoFrameInto) are only wrapped for this call, levels attached to them would be lost */
+    params.mipmaps = movie->video_mipmaps && !(target->flags & SDL_SURFACE_PREALLOCATED);
+
+    /* Transform may be swapped by another thread meanwhile, this frame keeps the one it started with */
+    GleedColorTransformTables *color = GleedAcquireVideoColorTransform(movie);
+    params.color = color;
+
+    /* Planes are read right where the decoders put them, cropped, scaled, merged with alpha and colour graded in the same pass */
+    const bool converted = GleedConvertYUVFrame(&frame, ctx->last_alpha, &params, target);
+
+    movie->video_frame_transformed = color != NULL;
+    GleedReleaseColorTransform(color);
+
+    if (!converted)
+    {
+        return false;
+    }
+
+    const Uint64 convert_ns = SDL_GetTicksNS() - convert_start;
+
+    movie->video_stats.converted_frames++;
+    movie->video_stats.convert_ns += convert_ns;
+
+    movie->last_frame_decode_ns = ctx->last_decode_ns + convert_ns;
+    movie->last_frame_decode_ms = (Uint32)SDL_NS_TO_MS(movie->last_frame_decode_ns);
+
+    return true;
+}
+
+static void VPXFlushCodec(vpx_codec_ctx_t *codec)
+{
+    vpx_codec_decode(codec, NULL, 0, NULL, 0);
+
+    vpx_codec_iter_t iter = NULL;
+    while (vpx_codec_get_frame(codec, &iter) != NULL)
     {
-        buffer_size += vpx_img_plane_height(img, plane) * img->stride[plane];
     }
+}
+
+void GleedResetVPX(GleedMovie *movie)
+{
+    if (!movie->vpx_context)
+        return;
 
-    if (!movie->conversion_video_frame_buffer)
+    VPXContext *ctx = (VPXContext *)movie->vpx_context;
+
+    vpx_codec_ctx_t *codec = movie->video_codec == GLEED_CODEC_TYPE_VP8 ? &ctx->codec8 : &ctx->codec9;
+
+    if ((movie->video_codec == GLEED_CODEC_TYPE_VP8 && !ctx->vp8) || (movie->video_codec == GLEED_CODEC_TYPE_VP9 && !ctx->vp9))
+        return;
+
+    /* Flush frames still held by the decoder, next keyframe takes care of the references */
+    VPXFlushCodec(codec);
+
+    ctx->last_image = NULL;
+    ctx->last_alpha = NULL;
+
+    /* Alpha worker is idle between frames, so its decoder can be flushed from here */
+    if (ctx->alpha)
     {
-        movie->conversion_video_frame_buffer = (Uint8 *)SDL_calloc(
-            1, buffer_size);
-        movie->conversion_video_frame_buffer_size = buffer_size;
+        GleedResetVPXDecoder(ctx->alpha->decoder);
     }
-    else if (movie->conversion_video_frame_buffer_size < buffer_size)
+}
+
+const GleedVideoFrameYUV *GleedAcquireVPXFrame(GleedMovie *movie)
+{
+    VPXContext *ctx = (VPXContext *)movie->vpx_context;
+
+    if (!ctx || !ctx->last_image || !movie->video_frame_shown)
     {
-        movie->conversion_video_frame_buffer = (Uint8 *)SDL_realloc(
-            movie->conversion_video_frame_buffer, buffer_size);
-        movie->conversion_video_frame_buffer_size = buffer_size;
+        GleedSetError("No decoded video frame available");
+        return NULL;
     }
 
-    Uint8 *convert_buffer = movie->conversion_video_frame_buffer;
+    const vpx_image_t *img = ctx->last_image;
 
-    Uint8 *convert_buffer_write_ptr = convert_buffer;
+    GleedVideoFrameRef *ref = (GleedVideoFrameRef *)SDL_calloc(1, sizeof(GleedVideoFrameRef));
 
-    size_t bytes_copied = 0;
+    if (!ref)
+    {
+        GleedSetError("Failed to allocate memory for video frame");
+        return NULL;
+    }
 
-    /* Some hacky conversion from VPX img planes format to SDL continuous buffer with 3 planes*/
-    for (int plane = 0; plane < 3; plane++)
+    vpx_img_to_yuv_frame(img, &ref->yuv);
+
+    if (movie->video_codec == GLEED_CODEC_TYPE_VP9 && img->fb_priv)
+    {
+        /* Image already lives in our pool, just keep the decoder from reusing its buffer */
+        ref->buffer = (GleedFrameBuffer *)img->fb_priv;
+        GleedRetainFrameBuffer(ref->buffer);
+    }
+    else
     {
-        const int plane_height = vpx_img_plane_height(img, plane);
-        const int plane_width = vpx_img_plane_width(img, plane);
-        const int row_size_bytes = img->stride[plane];
+        /* Decoder owned memory (VP8) is overwritten by the next frame, so planes are copied once into a pooled buffer */
+        const int bytes_per_sample = (img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) ? 2 : 1;
+
+        int pitches[3];
+        size_t size = 0;
+
+        for (int plane = 0; plane < 3; plane++)
+        {
+            pitches[plane] = (vpx_img_plane_width(img, plane) * bytes_per_sample + 31) & ~31;
+            size += (size_t)pitches[plane] * vpx_img_plane_height(img, plane);
+        }
+
+        ref->buffer = GleedGetFrameBuffer(ctx->frame_pool, size);
+
+        if (!ref->buffer)
+        {
+            SDL_free(ref);
+            return NULL;
+        }
+
+        Uint8 *dst = ref->buffer->data;
 
-        for (int y = 0; y < plane_height; y++)
+        for (int plane = 0; plane < 3; plane++)
         {
-            SDL_memcpy(
-                convert_buffer_write_ptr,
-                img->planes[plane] + y * img->stride[plane],
-                row_size_bytes);
-            convert_buffer_write_ptr += row_size_bytes;
-            bytes_copied += row_size_bytes;
+            const int row_size = vpx_img_plane_width(img, plane) * bytes_per_sample;
+            const int rows = vpx_img_plane_height(img, plane);
+
+            ref->yuv.planes[plane] = dst;
+            ref->yuv.pitches[plane] = pitches[plane];
+
+            for (int y = 0; y < rows; y++)
+            {
+                SDL_memcpy(dst + y * pitches[plane], img->planes[plane] + y * img->stride[plane], row_size);
+            }
+
+            dst += (size_t)pitches[plane] * rows;
         }
     }
 
-    SDL_assert(convert_buffer_write_ptr - convert_buffer == buffer_size);
-    SDL_assert(bytes_copied == buffer_size);
+    ref->pool = ctx->frame_pool;
+    GleedRetainFrameBufferPool(ref->pool);
 
-    SDL_LockSurface(movie->current_frame_surface);
+    return &ref->yuv;
+}
 
-    /* Thank you SDL for this monster helper! */
-    if (!SDL_ConvertPixelsAndColorspace(
-            img->d_w,
-            img->d_h,
-            vpx_format_details->format,
-            vpx_colorspace,
-            0,
-            convert_buffer,
-            img->stride[0],
-            rgb_format_details->format,
-            SDL_GetSurfaceColorspace(movie->current_frame_surface),
-            0,
-            movie->current_frame_surface->pixels,
-            movie->current_frame_surface->pitch))
+static void VPXDestroyContext(void *context)
+{
+    VPXContext *ctx = (VPXContext *)context;
+
+    if (ctx->vp8)
     {
-        GleedSetError("Failed to convert VPX frame to RGB: %s", SDL_GetError());
-        SDL_free(convert_buffer);
+        vpx_codec_destroy(&ctx->codec8);
+    }
 
-        return false;
+    if (ctx->vp9)
+    {
+        vpx_codec_destroy(&ctx->codec9);
     }
 
-    SDL_UnlockSurface(movie->current_frame_surface);
+    VPXDestroyAlphaWorker(ctx->alpha);
 
-    movie->last_frame_decode_ms = SDL_GetTicks() - decode_start;
+    /* Acquired frames keep their own pool reference, so they survive this */
+    GleedReleaseFrameBufferPool(ctx->frame_pool);
 
-    return true;
+    SDL_free(ctx);
 }
 
 void GleedCloseVPX(GleedMovie *movie)
@@ -237,20 +974,122 @@ void GleedCloseVPX(GleedMovie *movie)
     {
         VPXContext *ctx = (VPXContext *)movie->vpx_context;
 
+        /* Flushed decoders are as good as new ones: the next movie starts with a keyframe anyway */
         if (ctx->vp8)
-        {
-            vpx_codec_destroy(&ctx->codec8);
-            ctx->vp8 = NULL;
-        }
+            VPXFlushCodec(&ctx->codec8);
 
         if (ctx->vp9)
-        {
-            vpx_codec_destroy(&ctx->codec9);
-            ctx->vp9 = NULL;
-        }
+            VPXFlushCodec(&ctx->codec9);
+
+        if (ctx->alpha)
+            GleedResetVPXDecoder(ctx->alpha->decoder);
 
-        SDL_free(ctx);
+        ctx->last_image = NULL;
+        ctx->last_alpha = NULL;
+        ctx->last_decode_ns = 0;
+
+        GleedParkPooledDecoder(GLEED_POOLED_DECODER_VPX, movie->video_codec, ctx, VPXDestroyContext);
 
         movie->vpx_context = NULL;
     }
-}
\ No newline at end of file
+}
+
+struct GleedVPXDecoder
+{
+    vpx_codec_ctx_t codec;
+    vpx_image_t *last_image; /**< Last image returned by the decoder, valid until the next decode call */
+};
+
+GleedVPXDecoder *GleedCreateVPXDecoder(GleedMovieCodecType codec)
+{
+    vpx_codec_iface_t *vpi = NULL;
+
+    if (codec == GLEED_CODEC_TYPE_VP8)
+    {
+        vpi = vpx_codec_vp8_dx();
+    }
+    else if (codec == GLEED_CODEC_TYPE_VP9)
+    {
+        vpi = vpx_codec_vp9_dx();
+    }
+
+    if (!vpi)
+    {
+        GleedSetError("Unsupported video codec");
+        return NULL;
+    }
+
+    GleedVPXDecoder *decoder = (GleedVPXDecoder *)SDL_calloc(1, sizeof(GleedVPXDecoder));
+
+    if (!decoder)
+    {
+        GleedSetError("Failed to allocate memory for VPX decoder");
+        return NULL;
+    }
+
+    /* Standalone decoders are meant to run side by side, one thread each is plenty */
+    vpx_codec_dec_cfg_t cfg = {1, 0, 0};
+
+    vpx_codec_err_t err = vpx_codec_dec_init(&decoder->codec, vpi, &cfg, 0);
+
+    if (err != VPX_CODEC_OK)
+    {
+        GleedSetError("Failed to initialize VPX decoder: %s", vpx_codec_err_to_string(err));
+        SDL_free(decoder);
+        return NULL;
+    }
+
+    return decoder;
+}
+
+bool GleedDecodeVPXPacket(GleedVPXDecoder *decoder, const Uint8 *data, size_t size, Uint32 frame, GleedVideoFrameYUV *yuv, bool *shown)
+{
+    *shown = false;
+    decoder->last_image = NULL;
+
+    vpx_codec_err_t decode_err = vpx_codec_decode(&decoder->codec, data, (unsigned int)size, (void *)(uintptr_t)frame, 0);
+
+    if (decode_err != VPX_CODEC_OK)
+    {
+        return GleedSetError("Failed to decode VPX frame: %s, %s", vpx_codec_err_to_string(decode_err), vpx_codec_error_detail(&decoder->codec));
+    }
+
+    vpx_codec_iter_t iter = NULL;
+    vpx_image_t *next_img = NULL;
+
+    /* Same as GleedDecodeVPX: drain everything, the last image is the shown one */
+    while ((next_img = vpx_codec_get_frame(&decoder->codec, &iter)) != NULL)
+    {
+        decoder->last_image = next_img;
+    }
+
+    if (decoder->last_image)
+    {
+        vpx_img_to_yuv_frame(decoder->last_image, yuv);
+        *shown = true;
+    }
+
+    return true;
+}
+
+void GleedSetVPXDecoderQuality(GleedVPXDecoder *decoder, GleedVideoDecodeQuality quality)
+{
+    /* Fails harmlessly for VP8, which has no such control */
+    vpx_codec_control(&decoder->codec, VP9_SET_SKIP_LOOP_FILTER, quality >= GLEED_VIDEO_QUALITY_FASTEST);
+}
+
+void GleedResetVPXDecoder(GleedVPXDecoder *decoder)
+{
+    decoder->last_image = NULL;
+
+    VPXFlushCodec(&decoder->codec);
+}
+
+void GleedDestroyVPXDecoder(GleedVPXDecoder *decoder)
+{
+    if (!decoder)
+        return;
+
+    vpx_codec_destroy(&decoder->codec);
+    SDL_free(decoder);
+}
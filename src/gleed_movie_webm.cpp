@@ -4,8 +4,13 @@
 #include <webm/callback.h>
 #include <webm/istream_reader.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 static constexpr int kWebmReaderError = 1;
 static constexpr int kWebmReaderEof = 2;
+static constexpr int kWebmIndexError = 3; /* Error is already set by the index */
 
 class SDLWebmIoReader : public webm::Reader
 {
@@ -95,6 +100,10 @@ public:
     GleedMovieWebmCallback(GleedMovie *movie)
     {
         m_movie = movie;
+        m_currentBlockTrack = -1;
+        m_isInKeyFrameBlock = false;
+        m_isInHiddenBlock = false;
+        m_lastAddedFrame = -1;
     }
 
     webm::Status OnInfo(const webm::ElementMetadata &metadata, const webm::Info &info) override
@@ -123,13 +132,12 @@ public:
                                     const webm::SimpleBlock &simple_block,
                                     webm::Action *action) override
     {
-        if (!simple_block.is_visible)
-        {
-            *action = webm::Action::kSkip;
-            return webm::Status(webm::Status::kOkCompleted);
-        }
-
+        /*
+            Invisible blocks (e.g. VP8 alt-ref frames) are never displayed,
+            but they still update decoder references, so we must index them too.
+        */
         m_isInKeyFrameBlock = simple_block.is_key_frame;
+        m_isInHiddenBlock = !simple_block.is_visible;
 
         m_currentBlockTrack = GleedFindTrackByNumber(m_movie, simple_block.track_number);
         m_currentBlockTimecode = simple_block.timecode;
@@ -141,39 +149,141 @@ public:
                                   const webm::SimpleBlock &simple_block) override
     {
         m_isInKeyFrameBlock = false;
+        m_isInHiddenBlock = false;
         return webm::Status(webm::Status::kOkCompleted);
     }
 
     webm::Status OnBlockBegin(const webm::ElementMetadata &metadata,
                               const webm::Block &block, webm::Action *action) override
     {
-        if (!block.is_visible)
-        {
-            *action = webm::Action::kSkip;
-            return webm::Status(webm::Status::kOkCompleted);
-        }
-
         if (block.num_frames == 0)
         {
             *action = webm::Action::kSkip;
             return webm::Status(webm::Status::kOkCompleted);
         }
 
+        /* Block elements do not carry a keyframe flag, unlike SimpleBlock */
+        m_isInKeyFrameBlock = false;
+        m_isInHiddenBlock = !block.is_visible;
+
         m_currentBlockTrack = GleedFindTrackByNumber(m_movie, block.track_number);
         m_currentBlockTimecode = block.timecode;
         *action = m_currentBlockTrack >= 0 ? webm::Action::kRead : webm::Action::kSkip;
         return webm::Status(webm::Status::kOkCompleted);
     }
 
+    webm::Status OnElementBegin(const webm::ElementMetadata &metadata, webm::Action *action) override
+    {
+        /* BlockAdditional is handed over already read, only here do we learn where it lives in the file */
+        if (metadata.id == webm::Id::kBlockMore)
+        {
+            m_blockAdditionals.emplace_back(0, 0);
+        }
+        else if (metadata.id == webm::Id::kBlockAdditional && !m_blockAdditionals.empty())
+        {
+            m_blockAdditionals.back() = std::make_pair(metadata.position + metadata.header_size, metadata.size);
+        }
+
+        *action = webm::Action::kRead;
+        return webm::Status(webm::Status::kOkCompleted);
+    }
+
+    webm::Status OnBlockGroupBegin(const webm::ElementMetadata &metadata, webm::Action *action) override
+    {
+        m_lastAddedFrame = -1;
+        m_blockAdditionals.clear();
+        *action = webm::Action::kRead;
+        return webm::Status(webm::Status::kOkCompleted);
+    }
+
+    webm::Status OnBlockGroupEnd(const webm::ElementMetadata &metadata,
+                                 const webm::BlockGroup &block_group) override
+    {
+        /*
+            Alpha of VP8/VP9 lives in BlockAdditional with BlockAddID 1, as a standalone stream of its own.
+            Only its position is attached to the frame the Block produced, it's read from the file on decode.
+        */
+        if (m_lastAddedFrame < 0 || !block_group.additions.is_present())
+        {
+            return webm::Status(webm::Status::kOkCompleted);
+        }
+
+        const GleedMovieTrack *track = &m_movie->tracks[m_currentBlockTrack];
+
+        if (track->type != GLEED_TRACK_TYPE_VIDEO || !track->video_alpha)
+        {
+            return webm::Status(webm::Status::kOkCompleted);
+        }
+
+        const auto &blockMores = block_group.additions.value().block_mores;
+
+        for (std::size_t i = 0; i < blockMores.size() && i < m_blockAdditionals.size(); i++)
+        {
+            const auto &more = blockMores[i].value();
+
+            if (more.id.value() == 1 && more.data.is_present() && !more.data.value().empty())
+            {
+                const auto &data = more.data.value();
+
+                if (m_blockAdditionals[i].second != data.size())
+                {
+                    GleedSetError("Failed to locate alpha payload of frame %d", m_lastAddedFrame);
+                    return webm::Status(kWebmIndexError);
+                }
+
+                if (!GleedAddCachedFrameAlpha(m_movie, m_currentBlockTrack, m_lastAddedFrame, m_blockAdditionals[i].first, data.data(), data.size()))
+                {
+                    return webm::Status(kWebmIndexError);
+                }
+
+                break;
+            }
+        }
+
+        return webm::Status(webm::Status::kOkCompleted);
+    }
+
     webm::Status OnFrame(const webm::FrameMetadata &metadata, webm::Reader *reader,
                          std::uint64_t *bytes_remaining) override
     {
+        m_lastAddedFrame = -1;
+
         if (m_currentBlockTrack != -1)
         {
+            bool isKeyFrame = m_isInKeyFrameBlock;
+
+            /*
+                Block elements carry no keyframe flag and muxers do not always set it right for SimpleBlocks either,
+                so for video we ask the bitstream itself - a few header bytes are enough.
+            */
+            const GleedMovieTrack *track = &m_movie->tracks[m_currentBlockTrack];
+
+            if (track->type == GLEED_TRACK_TYPE_VIDEO)
+            {
+                std::uint8_t header[4];
+                std::uint64_t headerSize = 0;
+
+                const auto status = ReadFrameHeader(reader, header, sizeof(header), bytes_remaining, &headerSize);
+
+                if (!status.ok())
+                {
+                    return status;
+                }
+
+                isKeyFrame = GleedIsVPXKeyFrame(GleedGetTrackCodec(track), header, headerSize);
+            }
+
             const auto resultingTimecode = m_currentClusterTimecode + m_currentBlockTimecode;
+            const auto framesBefore = m_movie->count_cached_frames[m_currentBlockTrack];
+
             GleedAddCachedFrame(
                 m_movie,
-                m_currentBlockTrack, resultingTimecode, metadata.position, metadata.size, m_isInKeyFrameBlock);
+                m_currentBlockTrack, resultingTimecode, metadata.position, metadata.size, isKeyFrame, m_isInHiddenBlock);
+
+            if (m_movie->count_cached_frames[m_currentBlockTrack] > framesBefore)
+            {
+                m_lastAddedFrame = framesBefore;
+            }
         }
 
         return Skip(reader, bytes_remaining);
@@ -246,6 +356,11 @@ public:
             mt->video_width = video.pixel_width.value();
             mt->video_height = video.pixel_height.value();
             mt->video_frame_rate = video.frame_rate.value();
+            mt->video_crop_top = video.pixel_crop_top.value();
+            mt->video_crop_bottom = video.pixel_crop_bottom.value();
+            mt->video_crop_left = video.pixel_crop_left.value();
+            mt->video_crop_right = video.pixel_crop_right.value();
+            mt->video_alpha = video.alpha_mode.value() == webm::AlphaMode::kPresent;
         }
         else if (mt->type == GLEED_TRACK_TYPE_AUDIO)
         {
@@ -283,10 +398,37 @@ public:
     }
 
 private:
+    webm::Status ReadFrameHeader(webm::Reader *reader, std::uint8_t *buffer, std::size_t size,
+                                 std::uint64_t *bytes_remaining, std::uint64_t *bytes_read)
+    {
+        const auto toRead = static_cast<std::size_t>(std::min<std::uint64_t>(size, *bytes_remaining));
+
+        *bytes_read = 0;
+
+        while (*bytes_read < toRead)
+        {
+            std::uint64_t numRead = 0;
+            const auto status = reader->Read(toRead - *bytes_read, buffer + *bytes_read, &numRead);
+
+            *bytes_read += numRead;
+            *bytes_remaining -= numRead;
+
+            if (!status.ok())
+            {
+                return status;
+            }
+        }
+
+        return webm::Status(webm::Status::kOkCompleted);
+    }
+
     GleedMovie *m_movie;
 
     int m_currentBlockTrack;
     bool m_isInKeyFrameBlock;
+    bool m_isInHiddenBlock;
+    int m_lastAddedFrame; /* Index of the frame added by the last Block, BlockAdditions come after it */
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> m_blockAdditionals; /* File offset and size of BlockAdditional of each BlockMore in the current group */
     Uint64 m_currentBlockTimecode;
     Uint64 m_currentClusterTimecode;
 };
@@ -302,6 +444,11 @@ extern "C"
 
         auto result = parser.Feed(&callback, &reader);
 
+        if (result.code == kWebmIndexError)
+        {
+            return false;
+        }
+
         if (!result.completed_ok() && result.code != kWebmReaderEof)
         {
             GleedSetError("Failed to parse webm file, result code: %d", result.code);
@@ -0,0 +1,98 @@
+#include "gleed_movie_internal.h"
+
+/* Hard cap of the thread array, pools ask for fewer */
+#define GLEED_WORKER_POOL_MAX_THREADS 16
+
+static void GleedFailWorkerPool(GleedWorkerPool *pool)
+{
+    if (SDL_CompareAndSwapAtomicInt(&pool->failed, 0, 1))
+    {
+        SDL_strlcpy(pool->error, GleedGetError(), sizeof(pool->error));
+    }
+
+    SDL_SetAtomicInt(&pool->stopped, 1);
+}
+
+static int GleedWorkerPoolThread(void *data)
+{
+    GleedWorkerPool *pool = (GleedWorkerPool *)data;
+
+    void *worker = NULL;
+
+    for (;;)
+    {
+        const int job = SDL_AddAtomicInt(&pool->next_job, 1);
+
+        if (job >= pool->job_count || SDL_GetAtomicInt(&pool->stopped))
+            break;
+
+        /* Worker is set up lazily, a thread may come late and find nothing left to do */
+        if (!worker)
+        {
+            worker = SDL_calloc(1, pool->worker_size ? pool->worker_size : 1);
+
+            if (!worker)
+            {
+                GleedSetError("Failed to allocate worker state of %s", pool->name);
+                GleedFailWorkerPool(pool);
+                break;
+            }
+
+            if (pool->init && !pool->init(pool, worker))
+            {
+                GleedFailWorkerPool(pool);
+                break;
+            }
+        }
+
+        if (!pool->run(pool, worker, job))
+        {
+            GleedFailWorkerPool(pool);
+            break;
+        }
+    }
+
+    if (worker && pool->cleanup)
+    {
+        pool->cleanup(pool, worker);
+    }
+
+    SDL_free(worker);
+
+    return 0;
+}
+
+bool GleedRunWorkerPool(GleedWorkerPool *pool)
+{
+    SDL_Thread *threads[GLEED_WORKER_POOL_MAX_THREADS - 1];
+    const int max_threads = SDL_min(pool->max_threads, GLEED_WORKER_POOL_MAX_THREADS);
+    const int thread_count = SDL_min(SDL_min(pool->job_count, SDL_GetNumLogicalCPUCores()), max_threads) - 1;
+
+    /* Calling thread is a worker too; if a thread can't be created, the remaining ones just take more jobs */
+    for (int i = 0; i < thread_count; i++)
+    {
+        threads[i] = SDL_CreateThread(GleedWorkerPoolThread, pool->name, pool);
+    }
+
+    GleedWorkerPoolThread(pool);
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    if (SDL_GetAtomicInt(&pool->failed))
+        return GleedSetError("%s", pool->error);
+
+    return true;
+}
+
+void GleedStopWorkerPool(GleedWorkerPool *pool)
+{
+    SDL_SetAtomicInt(&pool->stopped, 1);
+}
+
+bool GleedIsWorkerPoolStopped(GleedWorkerPool *pool)
+{
+    return SDL_GetAtomicInt(&pool->stopped) != 0;
+}